@@ -1,20 +1,48 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+//
 #include <cutemuduo/channel.hpp>
 #include <cutemuduo/noncopyable.hpp>
 #include <cutemuduo/socket.hpp>
+#include <cutemuduo/timer_queue.hpp>
 
 namespace cutemuduo {
 
 class EventLoop;
 class InetAddress;
 
+// Acceptor 丢弃连接的计数(可以被多个 Acceptor 共享, 任何线程都可以读)
+struct AcceptorCounters {
+    std::atomic<size_t> shed{0};      // fd 耗尽(EMFILE/ENFILE)时被直接关闭的连接数
+    std::atomic<size_t> rejected{0};  // 超过准入限制, accept 后立即关闭的连接数
+    std::atomic<size_t> paused{0};    // 超过准入限制而暂停 accept 的次数
+};
+
 class Acceptor : NonCopyable {
 public:
     using NewConnectionCallback = std::function<void(int sockfd, InetAddress const& peer_addr)>;
 
+    // 准入检查(每次 accept 之前调用): 返回 0 表示可以接受新连接, 否则表示超过限制, 值为建议多久之后再试
+    using AdmissionCallback = std::function<std::chrono::nanoseconds()>;
+
+    // 超过准入限制时的处理方式
+    // - kPauseAccept: 暂停监听 socket 的可读事件, 连接留在内核的 accept 队列中(队列满后内核丢弃 SYN, 对端重传)
+    // - kAcceptAndClose: accept 后立即关闭(RST), 对端马上得到失败, 不占用 accept 队列
+    enum class OverloadAction { kPauseAccept, kAcceptAndClose };
+
+    static constexpr int kDefaultAcceptBatch = 32;  // 每次可读事件最多 accept 的连接数
+
+    // listenAddr 可以是 IPv4/IPv6 地址或 Unix 域 socket 地址(见 InetAddress)
     Acceptor(EventLoop* loop, InetAddress const& listenAddr, bool reuseport);
 
+    // 接管一个已经 bind/listen 的监听 socket(热重启时从旧进程接过来的, 见 hot_restart.hpp), 不再创建/绑定
+    Acceptor(EventLoop* loop, int listen_fd);
+
     ~Acceptor();
 
 public:
@@ -24,17 +52,72 @@ public:
     // 监听本地端口
     void Listen();
 
+    // 停止接受新连接: 移出 Poller 并关闭监听(已完成握手但还没 accept 的连接会被内核重置)
+    void Stop();
+
+    // 监听 socket 已经交给其他进程(热重启): 之后 Stop 不 shutdown 监听 socket, 析构时不删除 Unix 域 socket 文件
+    // NOTE: 任何线程都可以调用
+    void SetHandedOff();
+
+    // 监听 socket 的 fd
+    int listen_fd() const { return accept_socket_.sockfd(); }
+
+    // 见 Socket::AttachReusePortCpuFilter(需在 Listen 之后调用)
+    bool AttachReusePortCpuFilter(int group_size);
+
+    // 所属的 EventLoop
+    EventLoop* loop() const { return loop_; }
+
     // 设置新连接的回调函数
     void SetNewConnectionCallback(NewConnectionCallback cb);
 
+    // 设置每次可读事件最多 accept 的连接数(>= 1), 连接风暴时减少 epoll_wait 的次数
+    // NOTE: 批量过大会让一次可读事件占用 loop 太久, 延迟同一个 loop 上其他连接的 IO
+    void SetAcceptBatch(int batch);
+
+    // 设置准入检查和超限时的处理方式
+    void SetAdmissionCallback(AdmissionCallback cb, OverloadAction action);
+
+    // 与其他 Acceptor 共享计数(kReusePortPerLoop 时 TcpServer 的所有 Acceptor 共用一份)
+    void SetCounters(std::shared_ptr<AcceptorCounters> counters);
+
+    AcceptorCounters const& counters() const { return *counters_; }
+
+    // fd 耗尽(EMFILE/ENFILE)时被直接关闭的连接数
+    size_t shed_connections() const { return counters_->shed.load(std::memory_order_relaxed); }
+
 private:
+    Acceptor(EventLoop* loop, int sockfd, std::string unix_path);
+
     void HandleRead();
 
-    EventLoop* loop_;                                // main loop
+    // fd 耗尽时: 释放预留的空闲 fd, accept 后立即关闭(对端收到 FIN), 再重新预留
+    // 否则监听 socket 一直可读, loop 会忙等; 返回 false 表示没有可用的预留 fd
+    bool ShedConnection();
+
+    // 超过准入限制(kAcceptAndClose): accept 后立即关闭, 返回 false 表示没有待 accept 的连接
+    bool RejectConnection();
+
+    // 超过准入限制(kPauseAccept): 暂停 accept, delay 之后恢复
+    void PauseAccepting(std::chrono::nanoseconds delay);
+
+    void ResumeAccepting();
+
+    EventLoop* loop_;                                // main loop(SO_REUSEPORT 多 Acceptor 模式下为各自的 Subloop)
     Socket accept_socket_;                           // listen socket(专门接受新连接)
     Channel accept_channel_;                         // listen channel
     bool listenning_;                                // 是否正在监听
+    int accept_batch_;                               // 每次可读事件最多 accept 的连接数
+    int idle_fd_;                                    // 预留的空闲 fd(/dev/null), fd 耗尽时用来 accept 并关闭连接
     NewConnectionCallback new_connection_callback_;  // 新连接回调函数
+
+    AdmissionCallback admission_callback_;        // 准入检查(为空表示不限制)
+    OverloadAction overload_action_;              // 超过准入限制时的处理方式
+    TimerId resume_timer_;                        // kPauseAccept: 恢复 accept 的定时器(seq == 0 表示没有暂停)
+    std::shared_ptr<AcceptorCounters> counters_;  // 丢弃连接的计数
+
+    std::string unix_path_;         // 监听的 Unix 域 socket 文件路径(析构时删除), 其他地址族/抽象命名空间为空
+    std::atomic<bool> handed_off_;  // 监听 socket 已经交给其他进程
 };
 
 }  // namespace cutemuduo
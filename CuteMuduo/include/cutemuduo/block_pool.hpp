@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+namespace cutemuduo {
+
+// 线程本地的定长内存块池: 按 64 字节分级缓存释放的内存块, 同一个线程再次分配同样大小时直接复用
+// NOTE: one loop per thread, 线程本地的内存池就是每个 loop 一个;
+// 连接、协程帧等在 loop 线程中反复创建/销毁的对象从这里分配, 不再每次都走 malloc/free;
+// 超过 kMaxPooledBlockSize 的分配直接走 ::operator new
+namespace block_pool {
+
+constexpr size_t kMaxPooledBlockSize = 2048;
+
+void* Allocate(size_t size);
+
+// NOTE: size 必须与 Allocate 时相同; 可以在任何线程中释放, 内存块归还到释放时所在线程的池中
+void Deallocate(void* ptr, size_t size);
+
+}  // namespace block_pool
+
+// 从 block_pool 分配的 STL 分配器(用于 std::allocate_shared 等)
+template <typename T>
+struct BlockAllocator {
+    using value_type = T;
+
+    BlockAllocator() noexcept = default;
+
+    template <typename U>
+    BlockAllocator(BlockAllocator<U> const&) noexcept {}
+
+    T* allocate(size_t n) { return static_cast<T*>(block_pool::Allocate(n * sizeof(T))); }
+
+    void deallocate(T* ptr, size_t n) noexcept { block_pool::Deallocate(ptr, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(BlockAllocator<U> const&) const noexcept {
+        return true;
+    }
+};
+
+}  // namespace cutemuduo
@@ -4,6 +4,8 @@
 #include <cstddef>
 #include <string>
 #include <vector>
+//
+#include <cutemuduo/block_pool.hpp>
 
 namespace cutemuduo {
 
@@ -86,7 +88,7 @@ private:
     char const* Begin() const { return buffer_.data(); }
 
 private:
-    std::vector<char> buffer_;  //
+    std::vector<char, BlockAllocator<char>> buffer_;  // NOTE: 初始大小的存储从 block_pool 分配
     size_t reader_index_;
     size_t writer_index_;
 
@@ -4,6 +4,7 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 //
 #include <cutemuduo/noncopyable.hpp>
 #include <cutemuduo/timestamp.hpp>
@@ -12,6 +13,24 @@ namespace cutemuduo {
 
 class EventLoop;
 
+// Channel 事件的处理者(如 TcpConnection): 一次虚函数调用直接分发到所属对象, 代替 4 个 std::function 中转
+// NOTE: 设置了 Handler 的 Channel 不再 Tie(每个事件 weak_ptr::lock 一次, 即一对原子加减),
+// 由所有者保证生命周期: Handler 只在 Channel 从 Poller 中 Remove 之后析构, 且不会在事件回调过程中析构
+// (例如 TcpConnection 的最后一个引用由 ConnectDestroyed 任务持有, 任务在本轮所有事件处理完之后才执行)
+class ChannelHandler {
+public:
+    virtual void HandleRead(Timestamp receive_time) = 0;
+
+    virtual void HandleWrite() = 0;
+
+    virtual void HandleClose() = 0;
+
+    virtual void HandleError() = 0;
+
+protected:
+    ~ChannelHandler() = default;
+};
+
 // NOTE: Channel 不拥有 fd, 而 Socket 创建并拥有 fd, Socket 析构时关闭 fd
 
 // HACK: 感觉 Channel 可以简单理解为对 fd 上发生事件及处理事件逻辑的封装
@@ -42,6 +61,16 @@ public:
     // 注册 Channel 的错误回调函数
     void SetErrorCallback(EventCallback cb);
 
+    // 设置事件处理者(设置后不再使用上面的回调函数, 见 ChannelHandler)
+    void SetHandler(ChannelHandler* handler);
+
+    // 所属对象名称的获取函数(只在看门狗报告慢回调时调用)
+    // NOTE: 用函数指针 + 上下文而不是 std::function, 不多占内存也不分配
+    using OwnerNameFunc = std::string const& (*)(void const* owner);
+
+    // 设置所属对象(如 TcpConnection)及其名称获取函数, 只对 Tie 过或设置了 Handler 的 Channel 生效
+    void SetOwnerName(OwnerNameFunc func, void const* owner);
+
 public:
     // 监听可读
     void EnableReading();
@@ -77,6 +106,10 @@ public:
     //
     void HandleEventWithGuard(Timestamp receiveTime);
 
+private:
+    // 按 revents_ 分发给 handler_
+    void HandleEventWithHandler(Timestamp receive_time);
+
 public:
     int fd() const;
 
@@ -122,15 +155,20 @@ private:
     // - socket 缓冲区有空间可写
     static const int kWriteEvent = EPOLLOUT;
 
-    // 事件发生时对应的回调函数
-    ReadEventCallback read_callback_;  // 绑定 TcpConnection::HandleRead(Timestamp receiveTime)
-    EventCallback write_callback_;     // 绑定 TcpConnection::HandleWrite()
-    EventCallback close_callback_;     // 绑定 TcpConnection::HandleClose()
-    EventCallback error_callback_;     // 绑定 TcpConnection::HandleError()
+    // 事件发生时对应的回调函数(Acceptor、TimerQueue 等使用; TcpConnection 使用 handler_)
+    ReadEventCallback read_callback_;  // 可读回调
+    EventCallback write_callback_;     // 可写回调
+    EventCallback close_callback_;     // 关闭回调
+    EventCallback error_callback_;     // 错误回调
+
+    ChannelHandler* handler_;  // 事件处理者(非空时代替上面的回调函数)
 
-    // HACK: 想象成 <监视> TcpConnection 的生命周期
+    // HACK: 想象成 <监视> 所属对象的生命周期
     // 如果 lock() 失败, 说明 TcpConnection 对象已经销毁了, 就不调用回调
-    std::weak_ptr<void> tie_;  // 绑定 shared_ptr<TcpConnection>
+    std::weak_ptr<void> tie_;  // 绑定所属对象的 shared_ptr
     bool tied_;
+
+    OwnerNameFunc owner_name_func_;  // 看门狗日志中显示的所属对象名称
+    void const* owner_;
 };
 }  // namespace cutemuduo
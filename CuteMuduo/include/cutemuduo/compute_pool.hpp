@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+//
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/noncopyable.hpp>
+#include <cutemuduo/thread.hpp>
+#include <cutemuduo/unique_function.hpp>
+
+namespace cutemuduo {
+
+// 计算线程池(work stealing), 用来把压缩、JSON 解析等 CPU 密集的工作移出 IO 线程
+//
+// - 每个工作线程一个双端队列: 自己从队尾取(LIFO, 缓存友好), 其他线程从队头偷(FIFO)
+// - 自己的队列为空时随机挑一个起点依次尝试偷取其他线程的任务, 都没有才睡眠
+// - 工作线程中 Submit 的任务放进自己的队列; 其他线程 Submit 的任务轮流放进各个队列
+//
+// 与 EventLoop 配合(见 EventLoop::Offload):
+//   loop->SetComputePool(&pool);
+//   loop->Offload([data] { return Compress(data); },
+//                 [conn](std::string out) { conn->Send(std::move(out)); });  // 回到 loop 线程执行
+//
+// NOTE: 完成回调(then)先攒在工作线程本地, 按 EventLoop 分组, 在该线程自己的队列取空(去偷取之前, 偷来的任务可能
+// 很慢)或攒满 kMaxCompletionBatch 时每个 loop 只 QueueInLoop 一次, 一批任务完成只引起一次唤醒
+class ComputePool : NonCopyable {
+public:
+    using Task = UniqueFunction<void()>;
+
+    static constexpr size_t kMaxCompletionBatch = 64;  // 每个工作线程最多攒多少个完成回调再投递
+
+    explicit ComputePool(int num_workers, std::string const& name = "ComputePool");
+
+    // 调用 Stop()
+    ~ComputePool();
+
+public:
+    // 启动工作线程
+    void Start();
+
+    // 执行完已提交的任务后停止并回收工作线程
+    void Stop();
+
+    // 提交任务(任意线程), 返回任务是否被接受
+    // NOTE: Stop 之后提交的任务被拒绝(返回 false, 任务不执行): 调用线程通常是 IO 线程, 不能在这里执行 CPU 密集的任务
+    bool Submit(Task task);
+
+    // 在 loop 线程中执行 then: 在工作线程中调用时攒批投递, 否则直接 RunInLoop
+    static void PostCompletion(EventLoop* loop, EventLoop::Functor then);
+
+public:
+    int num_workers() const { return static_cast<int>(workers_.size()); }
+
+    // 累计被其他线程偷走执行的任务数
+    uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    // 工作线程执行函数
+    void WorkerLoop(int index);
+
+    // 从自己的队列尾部取一个任务
+    bool PopLocal(int index, Task& task);
+
+    // 随机选择起点, 从其他线程的队列头部偷一个任务
+    bool Steal(int thief, Task& task);
+
+    // 唤醒一个睡眠中的工作线程(如果有)
+    void NotifyOne();
+
+private:
+    std::string name_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::unique_ptr<Thread>> threads_;
+
+    std::atomic_bool running_;
+    std::atomic_bool stopped_;         // Stop 已回收工作线程: Submit 拒绝新任务
+    std::atomic<size_t> next_worker_;  // 外部线程 Submit 时轮流选择的队列
+    std::atomic<int64_t> pending_;     // 已提交还没被取走的任务数
+    std::atomic<int> idle_workers_;    // 正在睡眠(或准备睡眠)的工作线程数
+    std::atomic<uint64_t> steals_;
+
+    std::mutex sleep_mtx_;
+    std::condition_variable sleep_cv_;
+};
+
+// EventLoop::Offload 依赖 ComputePool, 定义放在这里
+template <typename Work, typename Then>
+bool EventLoop::Offload(Work&& work, Then&& then) {
+    using Result = std::invoke_result_t<std::decay_t<Work>&>;
+    return SubmitCompute([this, work = std::forward<Work>(work), then = std::forward<Then>(then)]() mutable {
+        if constexpr (std::is_void_v<Result>) {
+            work();
+            ComputePool::PostCompletion(this, [then = std::move(then)]() mutable { then(); });
+        } else {
+            ComputePool::PostCompletion(
+                this, [then = std::move(then), result = work()]() mutable { then(std::move(result)); });
+        }
+    });
+}
+
+}  // namespace cutemuduo
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+//
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/noncopyable.hpp>
+#include <cutemuduo/timer_queue.hpp>
+
+namespace cutemuduo {
+
+class Channel;
+class EventLoop;
+
+// 主动发起连接(TcpClient 使用): 非阻塞 connect, 等待 socket 可写(EPOLLOUT)后检查 SO_ERROR 得到连接结果
+// 连接失败时按指数退避重试: 每次失败后间隔翻倍(不超过 max_retry_delay), 实际等待时间在 [间隔/2, 间隔] 内随机,
+// 避免大量客户端在服务端重启后同时重连; 断线重连时只有上一个连接保持了 kStableConnectionTime 以上才重置退避(见 Restart)
+// NOTE: 通过 shared_ptr 持有(Start/Stop 投递的任务持有 shared_from_this(), 重试定时器持有 weak_ptr)
+class Connector : NonCopyable, public std::enable_shared_from_this<Connector> {
+public:
+    // 连接成功: sockfd 交给回调方(负责关闭)
+    using NewConnectionCallback = std::function<void(int sockfd)>;
+
+    static constexpr std::chrono::milliseconds kInitialRetryDelay{500};
+    static constexpr std::chrono::milliseconds kMaxRetryDelay{30 * 1000};
+    static constexpr std::chrono::milliseconds kStableConnectionTime{5 * 1000};  // 连接保持多久才认为服务端正常
+
+    Connector(EventLoop* loop, InetAddress const& server_addr);
+
+    ~Connector();
+
+public:
+    void SetNewConnectionCallback(NewConnectionCallback cb) { new_connection_callback_ = std::move(cb); }
+
+    // 设置重试间隔(需在 Start 之前调用)
+    void SetRetryDelay(std::chrono::milliseconds initial, std::chrono::milliseconds max);
+
+    // 开始连接(线程安全)
+    void Start();
+
+    // 交给回调方的连接已经关闭(只能在 loop 线程中调用): 回到 kDisconnected, 之后 Start/Restart 才会发起新的连接
+    void Disconnected();
+
+    // 重新开始连接(只能在 loop 线程中调用, 用于断线重连, 在 Disconnected 之后调用)
+    // 上一个连接保持了 kStableConnectionTime 以上: 重试间隔从初始值开始, 立即连接
+    // 否则(例如服务端 accept 之后立即关闭)按当前间隔退避之后再连接, 间隔继续翻倍
+    void Restart();
+
+    // 停止连接和重试(线程安全); 已经交给回调方的连接不受影响
+    void Stop();
+
+    InetAddress const& server_address() const { return server_addr_; }
+
+private:
+    enum class State { kDisconnected, kConnecting, kConnected };
+
+    void StartInLoop();
+
+    void StopInLoop();
+
+    void Connect();
+
+    // connect 已经发起(EINPROGRESS): 等待 socket 可写
+    void Connecting(int sockfd);
+
+    void HandleWrite();
+
+    void HandleError();
+
+    // 关闭 sockfd, 退避之后再次连接
+    void Retry(int sockfd);
+
+    // 从 Poller 中移除 Channel 并返回其 fd; Channel 延后到任务阶段销毁(可能正处于它的事件回调中)
+    int RemoveAndResetChannel();
+
+    EventLoop* loop_;
+    InetAddress server_addr_;                         // 服务端地址
+    std::atomic<bool> connect_;                       // 是否需要连接(Stop 之后为 false)
+    State state_;                                     // 只在 loop 线程中访问
+    std::unique_ptr<Channel> channel_;                // 正在连接的 socket 的 Channel
+    NewConnectionCallback new_connection_callback_;  // 连接成功回调
+    std::chrono::milliseconds initial_retry_delay_;  // 初始重试间隔
+    std::chrono::milliseconds max_retry_delay_;      // 最大重试间隔
+    std::chrono::milliseconds retry_delay_;          // 下一次重试间隔
+    TimerId retry_timer_;                            // 重试定时器(seq == 0 表示没有)
+    std::chrono::steady_clock::time_point connected_at_;  // 上一次连接成功的时间
+};
+
+}  // namespace cutemuduo
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <string>
+#include <utility>
+//
+#include <cutemuduo/block_pool.hpp>
+#include <cutemuduo/noncopyable.hpp>
+
+namespace cutemuduo {
+
+class EventLoop;
+class TcpConnection;
+
+// C++20 协程接口: 在已有的 EventLoop 上把回调式的协议处理写成顺序代码
+//
+//   Task<void> Echo(TcpConnectionPtr conn) {
+//       while (true) {
+//           std::string line = co_await conn->ReadUntil("\r\n");
+//           if (line.empty()) co_return;  // 对端关闭
+//           co_await conn->Write(line);
+//       }
+//   }
+//   server.SetConnectionCallback([](TcpConnectionPtr const& conn) {
+//       if (conn->IsConnected()) Spawn(Echo(conn));
+//   });
+//
+// NOTE: 协程在哪个 loop 线程里挂起, 就在哪个 loop 线程里恢复(SwitchTo 除外);
+// TcpConnection 的 Read/ReadUntil/Write 只能在连接所属的 loop 线程中 co_await
+
+// 所有 promise 的基类: 协程帧从当前线程的 block_pool 分配
+// NOTE: 协程可能 SwitchTo 到其他 loop 后结束, 帧会归还到结束时所在线程的内存池
+struct PooledPromise {
+    static void* operator new(size_t size) { return block_pool::Allocate(size); }
+    static void operator delete(void* ptr, size_t size) { block_pool::Deallocate(ptr, size); }
+};
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+template <typename T>
+struct TaskPromiseBase : PooledPromise {
+    std::coroutine_handle<> continuation;  // co_await 本 Task 的协程, 结束时恢复它
+    std::exception_ptr exception;
+
+    // 惰性启动: 被 co_await(或 Spawn)时才开始执行
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        // NOTE: 对称转移, 直接切换到等待者, 不会因为很长的 co_await 链而栈溢出
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            auto continuation = h.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase<T> {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+
+    void return_value(T v) { value.emplace(std::move(v)); }
+
+    T Result() {
+        if (this->exception) {
+            std::rethrow_exception(this->exception);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase<void> {
+    Task<void> get_return_object();
+
+    void return_void() {}
+
+    void Result() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+}  // namespace detail
+
+// 惰性协程, co_await 它得到返回值(或重新抛出协程中的异常)
+template <typename T>
+class Task : NonCopyable {
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+
+    explicit Task(Handle handle) : handle_(handle) {}
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+public:
+    struct Awaiter {
+        Handle handle;
+
+        bool await_ready() noexcept { return !handle || handle.done(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle.promise().continuation = awaiting;
+            return handle;  // 开始执行本 Task
+        }
+
+        T await_resume() { return handle.promise().Result(); }
+    };
+
+    Awaiter operator co_await() && noexcept { return Awaiter{handle_}; }
+
+    explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+
+private:
+    Handle handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+}  // namespace detail
+
+// 在当前线程中立即开始执行 task, 不等待其完成(task 结束后自动释放)
+// NOTE: task 中未捕获的异常会被记录到日志后丢弃
+void Spawn(Task<void> task);
+
+// 在 loop 线程中开始执行 task(线程安全)
+void Spawn(EventLoop* loop, Task<void> task);
+
+// =================== EventLoop 上的 awaiter ===================
+
+// co_await loop->Sleep(d)
+class SleepAwaiter {
+public:
+    SleepAwaiter(EventLoop* loop, std::chrono::nanoseconds delay) : loop_(loop), delay_(delay) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> h);
+
+    void await_resume() const noexcept {}
+
+private:
+    EventLoop* loop_;
+    std::chrono::nanoseconds delay_;
+};
+
+// co_await loop->SwitchTo(other)
+class SwitchToAwaiter {
+public:
+    explicit SwitchToAwaiter(EventLoop* target) : target_(target) {}
+
+    // 已经在目标 loop 线程中则不挂起
+    bool await_ready() const;
+
+    void await_suspend(std::coroutine_handle<> h);
+
+    void await_resume() const noexcept {}
+
+private:
+    EventLoop* target_;
+};
+
+// =================== TcpConnection 上的 awaiter ===================
+
+// co_await conn->Read(n) / conn->ReadUntil(delim)
+// 返回 n 字节(包含 delim 的一行); 对端关闭时返回输入缓冲区中剩下的数据(可能为空, 长度不足 n / 不含 delim)
+class ReadAwaiter {
+public:
+    ReadAwaiter(TcpConnection* conn, size_t n, std::string delim)
+        : conn_(conn), want_(n), delim_(std::move(delim)), scanned_(0), found_(0) {}
+
+    bool await_ready();
+
+    void await_suspend(std::coroutine_handle<> h);
+
+    std::string await_resume();
+
+private:
+    friend class TcpConnection;
+
+    // 输入缓冲区中的数据是否已满足条件(ReadUntil 时记录已扫描的位置, 避免重复查找)
+    bool Ready();
+
+    TcpConnection* conn_;
+    size_t want_;        // Read: 需要的字节数
+    std::string delim_;  // ReadUntil: 分隔符(非空)
+    size_t scanned_;     // ReadUntil: 已经查找过的字节数
+    size_t found_;       // ReadUntil: 分隔符之后的位置
+    std::coroutine_handle<> handle_;
+};
+
+// co_await conn->Write(data)
+// 数据全部写入内核(输出缓冲区清空)后恢复, 返回连接是否仍然有效
+class WriteAwaiter {
+public:
+    explicit WriteAwaiter(TcpConnection* conn) : conn_(conn) {}
+
+    bool await_ready();
+
+    void await_suspend(std::coroutine_handle<> h);
+
+    bool await_resume();
+
+private:
+    friend class TcpConnection;
+
+    TcpConnection* conn_;
+    std::coroutine_handle<> handle_;
+};
+
+}  // namespace cutemuduo
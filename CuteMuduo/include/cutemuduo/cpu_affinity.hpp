@@ -0,0 +1,48 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+namespace cutemuduo {
+
+// EventLoopThreadPool 中线程的 CPU 绑定配置(ThreadInitCallback 的配套设置, 见 EventLoopThreadPool::SetCpuAffinity)
+//
+// 绑定后线程不会被调度器在核之间(跨 NUMA 节点)迁移, 缓存保持热的;
+// 同时线程的内存策略设为 MPOL_LOCAL, loop 线程中分配的内存(EventLoop、Poller 事件数组、
+// Buffer 扩容等)落在该 CPU 所在的 NUMA 节点上
+struct CpuAffinity {
+    enum class Mode {
+        kNone,                // 不绑定(默认)
+        kCpuList,             // 第 i 个线程绑定 cpus[i % cpus.size()]
+        kOnePerPhysicalCore,  // 每个线程独占一个物理核(跳过超线程的兄弟逻辑 CPU), 按 NUMA 节点依次分配
+    };
+
+    Mode mode = Mode::kNone;
+    std::vector<int> cpus;  // kCpuList 时使用
+
+    static CpuAffinity None() { return {}; }
+
+    static CpuAffinity CpuList(std::vector<int> cpu_list) { return {Mode::kCpuList, std::move(cpu_list)}; }
+
+    static CpuAffinity OnePerPhysicalCore() { return {Mode::kOnePerPhysicalCore, {}}; }
+
+    // 按配置为 num_threads 个线程分配 CPU(-1 表示不绑定)
+    // NOTE: 线程数多于可用 CPU 时循环复用
+    std::vector<int> Assign(int num_threads) const;
+};
+
+namespace cpu_affinity {
+
+// 每个物理核取一个逻辑 CPU(编号最小的超线程), 按 (NUMA 节点, CPU 编号) 排序
+// 读取 /sys/devices/system/cpu 失败时退化为当前线程可用的所有 CPU
+std::vector<int> PhysicalCoreCpus();
+
+// cpu 所在的 NUMA 节点(未知时返回 0)
+int NumaNodeOfCpu(int cpu);
+
+// 把当前线程绑定到 cpu, 并把内存策略设为本地节点优先, 成功返回 true
+bool PinCurrentThread(int cpu);
+
+}  // namespace cpu_affinity
+
+}  // namespace cutemuduo
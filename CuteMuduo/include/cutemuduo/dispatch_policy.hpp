@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+//
+#include <cutemuduo/noncopyable.hpp>
+
+namespace cutemuduo {
+
+class EventLoop;
+class InetAddress;
+
+// 新连接分配到哪个 Subloop 的策略(EventLoopThreadPool::SetDispatchPolicy)
+// NOTE: Select 只在 Mainloop 中调用, 实现不需要加锁;
+// 各 loop 的连接数/近期延迟由 EventLoop::connections() / recent_latency_ns() 提供(任何线程都可以读)
+class DispatchPolicy : NonCopyable {
+public:
+    virtual ~DispatchPolicy() = default;
+
+    // 线程池启动后调用一次, loops 之后不再变化
+    virtual void Init(std::vector<EventLoop*> const& loops) { (void)loops; }
+
+    // 为来自 peer 的新连接选择 loops 中的一个(返回下标)
+    virtual size_t Select(std::vector<EventLoop*> const& loops, InetAddress const& peer) = 0;
+
+public:
+    // =================== 内置策略 ===================
+
+    // 轮询(与 GetNextLoop 相同)
+    static std::unique_ptr<DispatchPolicy> RoundRobin();
+
+    // 当前连接数最少的 loop
+    // NOTE: 适合长连接负载不均的场景; 连接数相同时轮询, 避免总是选第一个
+    static std::unique_ptr<DispatchPolicy> LeastConnections();
+
+    // 近期每轮事件循环忙碌时间最短的 loop(见 EventLoop::recent_latency_ns), 相同时选连接数少的
+    // NOTE: 适合连接数差不多但每个连接的负载差异很大的场景
+    static std::unique_ptr<DispatchPolicy> LeastLatency();
+
+    // 按对端 IP 一致性哈希: 同一个客户端的连接总是落在同一个 loop 上(便于共享 loop 本地的缓存/会话状态)
+    // virtual_nodes: 每个 loop 在哈希环上的虚拟节点数, 越多分布越均匀
+    // NOTE: 没有名字的对端(ToIp() 为空, 如未 bind 的 Unix 域 socket 客户端)无法区分, 这些连接改为轮询
+    static std::unique_ptr<DispatchPolicy> ConsistentHash(int virtual_nodes = 160);
+};
+
+}  // namespace cutemuduo
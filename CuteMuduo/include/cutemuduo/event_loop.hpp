@@ -1,18 +1,27 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
-#include <mutex>
+#include <vector>
 //
 #include <cutemuduo/current_thread.hpp>
+#include <cutemuduo/event_loop_stats.hpp>
+#include <cutemuduo/mpsc_queue.hpp>
 #include <cutemuduo/noncopyable.hpp>
+#include <cutemuduo/timer_queue.hpp>
 #include <cutemuduo/timestamp.hpp>
+#include <cutemuduo/unique_function.hpp>
+#include <cutemuduo/watchdog.hpp>
 
 namespace cutemuduo {
 
 class Channel;
+class ComputePool;
 class Poller;
+class SleepAwaiter;
+class SwitchToAwaiter;
 
 class EventLoop : NonCopyable {
 public:
@@ -27,53 +36,169 @@ public:
     void Quit();
 
     // 通过 wakeup_fd_ 唤醒 EventLoop
+    // NOTE: 已有未处理的唤醒时不再重复 write(2), 只计数(见 suppressed_wakeups())
     void Wakeup();
 
     // 判断当前 EventLoop 对象是否在自己的线程里
     bool IsInLoopThread() const;
 
-    using Functor = std::function<void()>;
+    // 是否正处于事件循环中(任何线程都可以调用): 为 false 时投递的任务要等下一次 Loop() 才会执行
+    bool looping() const { return looping_.load(); }
+
+    // NOTE: 只能移动, 捕获不超过 64 字节时不分配堆内存(见 unique_function.hpp)
+    using Functor = UniqueFunction<void()>;
+
+    // 任务优先级
+    // - kControl: 控制类任务(建立/销毁连接等), 每轮全部执行, 不受预算限制
+    // - kBulk:    普通任务(Send 等), 受 SetFunctorBudget 限制, 剩余的留到下一轮
+    enum class Priority { kControl, kBulk };
 
     // 在 EventLoop 当前所在线程中执行cb
     // 本线程调用: 立即执行
     // 其他线程调用: 加入队列, 异步执行
-    void RunInLoop(Functor cb);
+    void RunInLoop(Functor cb, Priority priority = Priority::kBulk);
 
     // 把上层注册的回调函数cb放入队列中, 唤醒loop所在的线程执行cb
     // 无论是本线程/其他线程, 都加入队列, 等 Loop() 轮到它执行
-    void QueueInLoop(Functor cb);
+    void QueueInLoop(Functor cb, Priority priority = Priority::kBulk);
 
-    // 在 EventLoop 所在线程中执行 pending_functors_ 中的回调函数
+    // 在 EventLoop 所在线程中执行 control_functors_ 和 pending_functors_ 中的回调函数
     void DoPendingFunctors();
 
+public:
+    // =================== 定时器(线程安全, 回调在 loop 线程中执行) ===================
+
+    // delay 之后执行一次 cb
+    TimerId RunAfter(std::chrono::nanoseconds delay, Functor cb);
+
+    // 每隔 interval 执行一次 cb
+    TimerId RunEvery(std::chrono::nanoseconds interval, Functor cb);
+
+    // 取消定时器
+    void CancelTimer(TimerId id);
+
+public:
+    // =================== 协程(见 coroutine.hpp) ===================
+
+    // co_await loop->Sleep(d): 挂起 d 之后在本 loop 线程中恢复
+    SleepAwaiter Sleep(std::chrono::nanoseconds delay);
+
+    // co_await loop->SwitchTo(other): 之后的代码在 other 的 loop 线程中继续执行
+    SwitchToAwaiter SwitchTo(EventLoop* other);
+
+public:
+    // 设置 Offload 使用的计算线程池(pool 的生命周期需长于本 loop 上的 Offload 调用)
+    void SetComputePool(ComputePool* pool);
+
+    ComputePool* compute_pool() const { return compute_pool_; }
+
+    // 在计算线程池中执行 work, 完成后回到本 loop 线程执行 then(work 的返回值)
+    // then 的签名: void() (work 返回 void) 或 void(Result)
+    // 返回 false 表示计算线程池已经 Stop, work 和 then 都不会执行, 由调用者决定如何处理(例如回复错误或关闭连接)
+    // NOTE: 定义在 compute_pool.hpp 中, 使用时需包含该头文件
+    template <typename Work, typename Then>
+    bool Offload(Work&& work, Then&& then);
+
+public:
+    // NOTE: 以下预算需在 loop 线程中(或 Loop() 开始前)设置, 0 表示不限制(默认)
+
+    // 每轮最多处理的活跃 Channel 数
+    // 超出的 Channel 本轮跳过; Poller 是水平触发的, 下一轮 Poll 会再次返回它们
+    void SetIoBudget(size_t max_channels);
+
+    // 每轮最多执行的 kBulk 任务数 / 执行时间, 剩余任务留到下一轮(下一轮 Poll 不阻塞)
+    void SetFunctorBudget(size_t max_functors, std::chrono::microseconds max_time = std::chrono::microseconds{0});
+
 public:
     // 以下均调用 poller 的方法
     void UpdateChannel(Channel* channel);
     void RemoveChannel(Channel* channel);
     bool HasChannel(Channel* channel);
 
+public:
+    // 实际写 wakeup_fd_ 的次数
+    uint64_t wakeups() const;
+
+    // 因已有未处理的唤醒而省掉的 write(2) 次数
+    uint64_t suppressed_wakeups() const;
+
+    // 运行时统计快照(任何线程都可以调用, 无锁)
+    EventLoopStats GetStats() const;
+
+    // 当前属于本 loop 的连接数(TcpServer 和 TcpClient 的连接; 任何线程都可以调用, 供 DispatchPolicy 使用)
+    size_t connections() const { return connections_.load(std::memory_order_relaxed); }
+
+    // 维护连接数(任何线程都可以调用): TcpServer 分配 loop 时加、从连接表移除时减, TcpClient 连接建立/关闭时加减
+    void AddConnection(size_t n = 1) { connections_.fetch_add(n, std::memory_order_relaxed); }
+
+    void RemoveConnection(size_t n = 1) { connections_.fetch_sub(n, std::memory_order_relaxed); }
+
+    // 近期的 loop 延迟: 每轮 IO + 任务耗时的滑动平均, 即新就绪的事件大约要等多久才被处理
+    // 已经阻塞在 Poll 中超过这个时间(空闲)时返回 0(任何线程都可以调用)
+    uint64_t recent_latency_ns() const;
+
+public:
+    // 挂上看门狗槽位(由 Watchdog::Watch 调用, 线程安全), 已经挂过时返回 false
+    bool AttachWatchdog(std::shared_ptr<WatchdogSlot> slot);
+
+    // 当前挂着的看门狗槽位(未启用时为 nullptr)
+    WatchdogSlot* watchdog() const { return watchdog_.load(std::memory_order_acquire); }
+
 private:
     // wakeup_channel_ 的读回调函数
     void HandleRead();
 
+    // 处理活跃 Channel 上的事件(受 io_budget_ 限制)
+    void HandleActiveChannels();
+
+    // 执行一个任务(启用看门狗时记录开始/结束)
+    void RunFunctor(Functor& functor, WatchdogSlot* watchdog);
+
+    // 把任务交给 compute_pool_(未设置时 LOG_FATAL), 返回 ComputePool::Submit 的结果
+    bool SubmitCompute(UniqueFunction<void()> task);
+
 private:
     std::atomic_bool looping_;  // 标记当前 EventLoop 是否处于事件循环中
     std::atomic_bool quit_;
-    std::mutex mtx_;
 
     Timestamp poll_return_time_;  // Poller返回发生事件的Channels的时间点
     std::unique_ptr<Poller> poller_;
 
     using ChannelList = std::vector<Channel*>;
     ChannelList active_channels_;  // 返回Poller检测到当前有事件发生的所有Channel列表
+    bool event_handling_;          // 是否正在处理 active_channels_(期间移除的 Channel 置空, 不再分发)
 
     // =================== one loop per thread ===================
     pid_t thread_id_;                          // 用于标识当前EventLoop所属的线程
     int wakeup_fd_;                            // 用于唤醒EventLoop的文件描述符
     std::unique_ptr<Channel> wakeup_channel_;  // 用于唤醒EventLoop的Channel
 
-    std::vector<Functor> pending_functors_;      // 用于存放需要在EventLoop所在线程中执行的回调函数
+    std::unique_ptr<TimerQueue> timer_queue_;  // 定时器队列(先于 poller_ 析构)
+
+    std::atomic_bool wakeup_pending_;           // 已写 wakeup_fd_ 但 loop 还没读走(合并唤醒)
+    std::atomic<uint64_t> wakeups_;             // 实际写 wakeup_fd_ 的次数
+    std::atomic<uint64_t> suppressed_wakeups_;  // 被合并掉的唤醒次数
+
+    MpscQueue<Functor> control_functors_;        // kControl 任务队列(无锁 MPSC 队列)
+    MpscQueue<Functor> pending_functors_;        // 用于存放需要在EventLoop所在线程中执行的回调函数(无锁 MPSC 队列)
     std::atomic_bool calling_pending_functors_;  // 标记当前是否正在执行 pending_functors_ 中的回调函数
+
+    // =================== 每轮预算 ===================
+    size_t io_budget_;                               // 每轮最多处理的活跃 Channel 数(0: 不限制)
+    size_t io_cursor_;                               // 超出 io_budget_ 时轮转处理的起点
+    size_t functor_budget_;                          // 每轮最多执行的 kBulk 任务数(0: 不限制)
+    std::chrono::microseconds functor_time_budget_;  // 每轮执行 kBulk 任务的时间上限(0: 不限制)
+    bool has_leftover_;                              // 本轮是否有剩余的 IO/任务(有则下一轮 Poll 不阻塞)
+
+    // =================== 运行时统计 ===================
+    alignas(64) EventLoopCounters counters_;  // 只有 loop 线程写, 独占 cache line 避免与生产者伪共享
+    alignas(64) std::atomic<size_t> connections_;  // 连接数(见 AddConnection/RemoveConnection)
+
+    ComputePool* compute_pool_;  // Offload 使用的计算线程池(可为空)
+
+    // =================== 慢回调看门狗 ===================
+    std::shared_ptr<WatchdogSlot> watchdog_slot_;  // 持有槽位(只在 AttachWatchdog 中写一次)
+    std::atomic<WatchdogSlot*> watchdog_;          // 热路径上只读这个指针(x86 上 acquire load 就是普通 load)
 };
 
 }  // namespace cutemuduo
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace cutemuduo {
+
+// EventLoop 运行时统计的快照(普通值, 可以跨 loop 累加)
+struct EventLoopStats {
+    uint64_t iterations = 0;          // Loop() 循环次数
+    uint64_t poll_events = 0;         // Poll 返回的事件总数
+    uint64_t max_poll_events = 0;     // 单次 Poll 返回的最大事件数
+    uint64_t poll_ns = 0;             // 阻塞在 Poll 中的时间
+    uint64_t io_ns = 0;               // 执行 Channel 回调的时间
+    uint64_t functor_ns = 0;          // 执行 DoPendingFunctors 的时间
+    uint64_t functors = 0;            // 执行的任务数
+    uint64_t pending_high_water = 0;  // 任务队列深度峰值(每轮执行任务之前已入队还未执行的任务数)
+    uint64_t wakeups = 0;             // 实际写 wakeup_fd_ 的次数
+    uint64_t suppressed_wakeups = 0;  // 被合并掉的唤醒次数
+    uint64_t connections = 0;         // 当前连接数
+    uint64_t recent_busy_ns = 0;      // 近期每轮 IO + 任务耗时的滑动平均(EWMA)
+
+    // 平均每次 Poll 返回的事件数
+    double EventsPerPoll() const;
+
+    // 累加(峰值/近期耗时取最大)
+    EventLoopStats& operator+=(EventLoopStats const& rhs);
+
+    // 单行文本, 便于打日志
+    std::string ToString() const;
+};
+
+// EventLoop 内部的计数器
+// NOTE: 只有 loop 线程写(load + store, 不需要 RMW), 任何线程都可以 relaxed load 得到近似快照
+struct EventLoopCounters {
+    std::atomic<uint64_t> iterations{0};
+    std::atomic<uint64_t> poll_events{0};
+    std::atomic<uint64_t> max_poll_events{0};
+    std::atomic<uint64_t> poll_ns{0};
+    std::atomic<uint64_t> io_ns{0};
+    std::atomic<uint64_t> functor_ns{0};
+    std::atomic<uint64_t> functors{0};
+    std::atomic<uint64_t> pending_high_water{0};
+    std::atomic<uint64_t> recent_busy_ns{0};
+    std::atomic<int64_t> polling_since_ns{0};  // 本轮开始阻塞在 Poll 中的时刻(0: 不在 Poll 中)
+
+    // 单写者累加
+    static void Add(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    // 单写者更新滑动平均: avg += (sample - avg) / 8
+    static void Ewma(std::atomic<uint64_t>& counter, uint64_t sample) {
+        uint64_t avg = counter.load(std::memory_order_relaxed);
+        counter.store(avg - avg / 8 + sample / 8, std::memory_order_relaxed);
+    }
+
+    // 单写者更新峰值
+    static void Max(std::atomic<uint64_t>& counter, uint64_t n) {
+        if (n > counter.load(std::memory_order_relaxed)) {
+            counter.store(n, std::memory_order_relaxed);
+        }
+    }
+};
+
+}  // namespace cutemuduo
@@ -18,7 +18,8 @@ public:
     // 线程初始化回调函数类型
     using ThreadInitCallback = std::function<void(EventLoop*)>;
 
-    EventLoopThread(ThreadInitCallback const& cb = ThreadInitCallback(), std::string const& name = "");
+    // cpu >= 0 时, 线程在创建 EventLoop 之前绑定到该 CPU(见 cpu_affinity.hpp)
+    EventLoopThread(ThreadInitCallback const& cb = ThreadInitCallback(), std::string const& name = "", int cpu = -1);
 
     ~EventLoopThread();
 
@@ -36,6 +37,7 @@ private:
     std::mutex mtx_;              // 互斥体
     std::condition_variable cv_;  // 条件变量
     ThreadInitCallback cb_;       // **用户自定义?** 线程初始化回调函数
+    int cpu_;                     // 绑定的 CPU(-1: 不绑定)
 };
 
 }  // namespace cutemuduo
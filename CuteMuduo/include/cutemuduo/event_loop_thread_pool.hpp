@@ -6,12 +6,16 @@
 #include <vector>
 
 //
+#include <cutemuduo/cpu_affinity.hpp>
+#include <cutemuduo/dispatch_policy.hpp>
+#include <cutemuduo/event_loop_stats.hpp>
 #include <cutemuduo/noncopyable.hpp>
 
 namespace cutemuduo {
 
 class EventLoop;
 class EventLoopThread;
+class InetAddress;
 
 class EventLoopThreadPool : NonCopyable {
 public:
@@ -26,13 +30,29 @@ public:
     // 设置线程数
     void SetThreadNum(int num_threads);
 
+    // 设置线程的 CPU 绑定方式(默认不绑定), 需在 Start() 之前调用
+    void SetCpuAffinity(CpuAffinity affinity);
+
     // 启动线程池(开启 num_threads_ 个线程并在每个线程启动事件循环)
     void Start(ThreadInitCallback const& cb = ThreadInitCallback());
 
+    // 设置新连接的分配策略(默认轮询), 需在 Start() 之前调用
+    void SetDispatchPolicy(std::unique_ptr<DispatchPolicy> policy);
+
+    // 轮询获取下一个 loop
     EventLoop* GetNextLoop();
 
+    // 按分配策略为来自 peer 的新连接选择 loop(只在 base_loop_ 线程中调用)
+    EventLoop* GetLoopFor(InetAddress const& peer);
+
     std::vector<EventLoop*> GetAllLoops() const;
 
+    // 汇总 GetAllLoops() 中所有 loop 的运行时统计(任何线程都可以调用)
+    EventLoopStats GetStats() const;
+
+    // GetAllLoops() 中各 loop 的当前连接数(任何线程都可以调用)
+    std::vector<size_t> GetConnectionCounts() const;
+
 public:
     bool started() const;
 
@@ -44,6 +64,8 @@ private:
     bool started_;                                           // 是否启动
     int num_threads_;                                        // 线程数
     int next_;                                               // 下一个线程索引
+    CpuAffinity affinity_;                                   // 线程的 CPU 绑定方式
+    std::unique_ptr<DispatchPolicy> policy_;                 // 新连接的分配策略(为空时轮询)
     std::vector<std::unique_ptr<EventLoopThread>> threads_;  // 线程列表
     std::vector<EventLoop*> loops_;                          // EventLoop 列表
 };
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+//
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/noncopyable.hpp>
+
+namespace cutemuduo {
+
+class Acceptor;
+class Channel;
+class EventLoop;
+class TcpServer;
+
+// 零停机热重启: 新进程通过 Unix 域 socket(SCM_RIGHTS)从旧进程接过监听 socket, 旧进程不再 accept 并优雅退出
+// 整个过程中监听 socket 一直存在, 新连接留在同一个 accept 队列中由新进程 accept, 不会被拒绝
+//
+// 协议(控制地址也由 HotRestart 监听, 其监听 socket 随 TcpServer 的监听 socket 一起交给新进程):
+//   1. 新进程 connect 控制地址, 失败说明没有旧进程(冷启动, 自己 bind)
+//   2. 旧进程回复 1 字节 'F', 附带 fd: [控制地址的监听 socket, TcpServer::listen_fds()...]
+//   3. 新进程用这些 fd 启动 TcpServer 并开始 accept 之后回复 1 字节 'A'
+//   4. 旧进程收到 'A' 后停止 accept(不 shutdown 监听 socket), 调用 HandoffCallback(通常是 TcpServer::Stop)
+//      新进程回复 'A' 之前退出(连接 EOF)时旧进程继续服务, 交出去的 fd 副本随新进程退出关闭
+//
+// 用法:
+//   EventLoop loop;
+//   HotRestart restart(&loop, InetAddress::UnixAbstract("my-server"));
+//   TcpServer server(&loop, InetAddress(8000), "Server");
+//   server.AdoptListenSockets(restart.Takeover());
+//   server.Start();
+//   restart.Serve(&server, [&] { server.Stop(std::chrono::seconds(5), [&](bool) { loop.Quit(); }); });
+//   loop.Loop();
+class HotRestart : NonCopyable {
+public:
+    // 监听 socket 已经交给新进程(在 loop 线程中回调)
+    using HandoffCallback = std::function<void()>;
+
+    // control_addr: 新旧进程之间的控制地址(Unix 域 socket, 建议用抽象命名空间, 不会残留 socket 文件)
+    HotRestart(EventLoop* loop, InetAddress const& control_addr);
+
+    // NOTE: 需在 loop 线程中析构
+    ~HotRestart();
+
+public:
+    // 新进程(阻塞): 向旧进程要监听 socket, 返回值交给 TcpServer::AdoptListenSockets
+    // 没有旧进程或 timeout 内没有收到时返回空(冷启动); 确认('A')在 Serve 中回复
+    std::vector<int> Takeover(std::chrono::milliseconds timeout = std::chrono::seconds(5));
+
+    // 开始监听控制地址, 等待下一个新进程来接管 server 的监听 socket(在 TcpServer::Start 之后调用)
+    void Serve(TcpServer* server, HandoffCallback cb);
+
+    // 监听 socket 是否已经交给新进程
+    bool handed_off() const { return handed_off_; }
+
+private:
+    void ServeInLoop();
+
+    // 新进程连接控制地址: 把监听 socket 发过去, 等待确认
+    void HandleSuccessor(int connfd);
+
+    // 新进程的确认('A')或 EOF
+    void HandleSuccessorRead();
+
+    void CloseSuccessor();
+
+    EventLoop* loop_;
+    InetAddress control_addr_;                    // 控制地址
+    TcpServer* server_;                           // 交出监听 socket 的 TcpServer
+    HandoffCallback handoff_callback_;            // 交出完成回调
+    std::unique_ptr<Acceptor> control_acceptor_;  // 控制地址的 Acceptor
+    int adopted_control_fd_;                      // Takeover: 从旧进程接过来的控制地址监听 socket(-1 表示没有)
+    int predecessor_fd_;                          // Takeover: 与旧进程的连接, Serve 时回复确认后关闭
+    std::unique_ptr<Channel> successor_channel_;  // 正在接管的新进程(同一时间只有一个)
+    bool handed_off_;                             // 监听 socket 已经交给新进程
+};
+
+}  // namespace cutemuduo
@@ -1,36 +1,57 @@
 #pragma once
 
 #include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include <string>
 
 namespace cutemuduo {
 
-// sockaddr_in 结构体的封装
+// socket 地址的封装: IPv4(sockaddr_in) / IPv6(sockaddr_in6) / Unix 域(sockaddr_un), 统一存放在 sockaddr_storage 中
 class InetAddress {
 public:
+    // ip 中含有 ':' 时为 IPv6 地址(如 "::1"), 否则为 IPv4 地址
     explicit InetAddress(uint16_t port = 0, std::string ip = "127.0.0.1");  // TODO: 默认值选择?
 
     explicit InetAddress(const sockaddr_in &addr);
 
+    explicit InetAddress(const sockaddr_in6 &addr);
+
+    // 任意地址族(如 accept/getsockname 得到的地址)
+    InetAddress(sockaddr const *addr, socklen_t len);
+
+    // Unix 域 socket: 文件系统路径
+    static InetAddress UnixPath(std::string const &path);
+
+    // Unix 域 socket: 抽象命名空间(Linux 特有, 不在文件系统中创建文件, 最后一个引用关闭后自动消失)
+    static InetAddress UnixAbstract(std::string const &name);
+
 public:
-    // 返回ip地址
+    // 地址族: AF_INET / AF_INET6 / AF_UNIX
+    sa_family_t family() const { return addr_.ss_family; }
+
+    // 返回ip地址(Unix 域 socket 返回路径, 抽象命名空间以 '@' 开头, 未命名时为空)
     std::string ToIp() const;
 
-    // 返回ip地址和端口
+    // 返回ip地址和端口(IPv6 为 "[ip]:port", Unix 域 socket 为 "unix:路径")
     std::string ToIpPort() const;
 
-    // 返回端口
+    // 返回端口(Unix 域 socket 返回 0)
     uint16_t ToPort() const;
 
-    // 返回sockaddr_in结构体
-    sockaddr_in const *GetSockAddr() const;
+    // 返回 sockaddr 结构体(可直接传给 bind/connect)
+    sockaddr const *GetSockAddr() const;
+
+    // sockaddr 的有效长度
+    socklen_t length() const { return len_; }
 
-    // 设置sockaddr_in结构体
-    void SetSockAddr(const sockaddr_in &addr);
+    // 设置 sockaddr 结构体
+    void SetSockAddr(sockaddr const *addr, socklen_t len);
 
 private:
-    sockaddr_in addr_;
+    sockaddr_storage addr_;
+    socklen_t len_;
 };
 
 }  // namespace cutemuduo
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+//
+#include <cutemuduo/noncopyable.hpp>
+
+namespace cutemuduo {
+
+// Dmitry Vyukov 的无锁 MPSC(多生产者单消费者) 队列
+//
+//   tail_(消费者)                                  head_(生产者)
+//      ↓                                              ↓
+//    [stub] -> [node1] -> [node2] -> ... -> [nodeN] -> nullptr
+//
+// - Push: 任意线程调用, 一次 exchange + 一次 store, 无锁且无等待
+// - Pop/ConsumeAll: 只能由**唯一的**消费者线程(EventLoop 所在线程)调用
+// NOTE: 生产者 exchange(head_) 之后、链接 prev->next 之前, 消费者会暂时看不到该节点(视为队列为空)
+// 对 EventLoop 而言这是安全的: 生产者 Push 返回后才 Wakeup, 下一轮循环一定能取到
+//
+// 节点回收: 消费者把用完的节点压入 free_list_(CAS), 生产者用 exchange 一次取走整条链表
+// 放进自己的 thread_local 缓存; 因为生产者只会"整体取走", 不存在 Treiber 栈单个 pop 的 ABA 问题
+// 稳定状态下 Push 不再分配内存
+//
+// 队列长度(SizeApprox)只在消费端统计, Push 没有额外的原子操作: 消费者记住上次数到的节点(counted_),
+// 每次只沿 next 数新链接上的节点, 每个节点只被数一次; 出队越过 counted_ 时把它推到新的 tail_
+// NOTE: counted_ 总是在 tail_ 或其之后, 而 tail_ 所指的节点(stub)不会被回收, 因此 counted_ 一直有效
+template <typename T>
+class MpscQueue : NonCopyable {
+public:
+    MpscQueue() : head_(&stub_), tail_(&stub_), counted_(&stub_), size_(0), free_list_(nullptr) {}
+
+    ~MpscQueue() {
+        T value;
+        while (Pop(value)) {
+        }
+        if (tail_ != &stub_) {
+            delete tail_;
+        }
+        DeleteList(free_list_.load(std::memory_order_acquire));
+    }
+
+public:
+    // 生产者: 任意线程
+    void Push(T value) {
+        Node* node = AllocNode();
+        node->value = std::move(value);
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);  // 串行化点
+        prev->next.store(node, std::memory_order_release);             // 链接到前一个节点
+    }
+
+    // 消费者: 取出一个元素, 队列为空返回 false
+    bool Pop(T& value) {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        // NOTE: next 成为新的 stub, 其中的值被移出; 旧的 tail 被回收(stub_ 除外)
+        value = std::move(next->value);
+        tail_ = next;
+        if (counted_ == tail) {
+            counted_ = next;  // 还没数到的节点: 出队即不再计入
+        } else {
+            --size_;
+        }
+        if (tail != &stub_) {
+            RecycleNode(tail);
+        }
+        return true;
+    }
+
+    // 消费者: 依次对**调用时刻已入队**的元素调用 fn, 返回处理的个数
+    // NOTE: fn 执行期间新入队的元素留到下一次, 与原先 swap(vector) 的语义一致, 防止 fn 自我重复入队导致死循环
+    template <typename Fn>
+    size_t ConsumeAll(Fn&& fn) {
+        Node* last = head_.load(std::memory_order_acquire);
+        size_t n = 0;
+        T value;
+        while (tail_ != last && Pop(value)) {
+            fn(value);
+            ++n;
+        }
+        return n;
+    }
+
+    // 消费者: 与 ConsumeAll 相同, 但最多处理 max_items 个, fn 返回 false 时提前停止(用于按时间预算截断)
+    template <typename Fn>
+    size_t ConsumeAtMost(size_t max_items, Fn&& fn) {
+        Node* last = head_.load(std::memory_order_acquire);
+        size_t n = 0;
+        T value;
+        while (n < max_items && tail_ != last && Pop(value)) {
+            ++n;
+            if (!fn(value)) {
+                break;
+            }
+        }
+        return n;
+    }
+
+    // 消费者: 已入队还未出队的元素个数(近似值, 不含生产者还没链接上的节点)
+    // NOTE: 只数上次调用之后新链接的节点, 均摊每个元素 O(1)
+    size_t SizeApprox() {
+        Node* last = head_.load(std::memory_order_acquire);
+        while (counted_ != last) {
+            Node* next = counted_->next.load(std::memory_order_acquire);
+            if (!next) {
+                break;
+            }
+            counted_ = next;
+            ++size_;
+        }
+        return size_;
+    }
+
+    // 消费者: 判断是否为空(近似值, 可能有生产者正在链接)
+    bool Empty() const { return tail_->next.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};  // 在队列中: 下一个节点; 在空闲链表中: 下一个空闲节点
+        T value{};
+    };
+
+    // 每个生产者线程的空闲节点缓存(同一 T 的所有队列共享, 线程退出时释放)
+    struct LocalCache {
+        ~LocalCache() { DeleteList(head); }
+
+        Node* head = nullptr;
+        size_t size = 0;
+    };
+
+    static constexpr size_t kMaxCachedNodes = 1024;  // 每个线程最多缓存的空闲节点数
+
+    static LocalCache& GetLocalCache() {
+        static thread_local LocalCache cache;
+        return cache;
+    }
+
+    static void DeleteList(Node* node) {
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    Node* AllocNode() {
+        LocalCache& cache = GetLocalCache();
+        if (!cache.head) {
+            // 一次取走消费者归还的所有节点, 超出缓存上限的部分直接释放
+            Node* node = free_list_.exchange(nullptr, std::memory_order_acquire);
+            while (node) {
+                Node* next = node->next.load(std::memory_order_relaxed);
+                if (cache.size < kMaxCachedNodes) {
+                    node->next.store(cache.head, std::memory_order_relaxed);
+                    cache.head = node;
+                    ++cache.size;
+                } else {
+                    delete node;
+                }
+                node = next;
+            }
+        }
+        if (Node* node = cache.head) {
+            cache.head = node->next.load(std::memory_order_relaxed);
+            --cache.size;
+            return node;
+        }
+        return new Node;
+    }
+
+    void RecycleNode(Node* node) {
+        Node* top = free_list_.load(std::memory_order_relaxed);
+        do {
+            node->next.store(top, std::memory_order_relaxed);
+        } while (!free_list_.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+private:
+    // NOTE: 生产者和消费者分别写 head_ / tail_, 放到不同 cache line 避免伪共享
+    alignas(64) std::atomic<Node*> head_;  // 最后入队的节点(生产者)
+    alignas(64) Node* tail_;               // 当前 stub 节点(消费者)
+    Node* counted_;                        // SizeApprox 已经数到的最后一个节点(消费者)
+    size_t size_;                          // tail_ 之后到 counted_ 为止的节点数(消费者)
+    std::atomic<Node*> free_list_;         // 消费者归还的空闲节点
+    Node stub_;
+};
+
+}  // namespace cutemuduo
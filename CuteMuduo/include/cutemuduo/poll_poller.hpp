@@ -0,0 +1,41 @@
+#pragma once
+
+#include <poll.h>
+
+#include <vector>
+//
+#include <cutemuduo/poller.hpp>
+
+namespace cutemuduo {
+
+class Channel;
+
+// 基于 poll(2) 的 Poller, 适合连接数较少的场景以及调试
+// NOTE: 通过环境变量 CUTEMUDUO_USE_POLL 启用(见 default_poller.cpp)
+class PollPoller : public Poller {
+public:
+    PollPoller(EventLoop* loop);
+
+    ~PollPoller() override;
+
+public:
+    // 内部调用 poll, 将有事件发生的 channel 通过 active_channels 返回
+    Timestamp Poll(int timeout_ms, ChannelList* active_channels) override;
+
+    // 更新 channel 上感兴趣的事件(如果 Channel 不在 Poller 中则添加进 Poller)
+    void UpdateChannel(Channel* channel) override;
+
+    // 从 pollfds_ 中移除 channel
+    void RemoveChannel(Channel* channel) override;
+
+private:
+    // 把有事件发生的 channel 添加到 active_channels 中
+    void FillActiveChannels(int num_events, ChannelList* active_channels) const;
+
+private:
+    // NOTE: Channel::index() 即 channel 在 pollfds_ 中的下标(-1: 还没添加)
+    using PollFdList = std::vector<pollfd>;
+    PollFdList pollfds_;  // poll 监听的 fd 列表
+};
+
+}  // namespace cutemuduo
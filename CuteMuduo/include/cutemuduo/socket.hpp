@@ -38,6 +38,10 @@ public:
     // 设置长连接
     void SetKeepAlive(bool on);
 
+    // 给 SO_REUSEPORT 组挂上按 CPU 选择监听 socket 的 cBPF 程序(SO_ATTACH_REUSEPORT_CBPF):
+    // 在 CPU c 上处理的新连接交给组内第 c % group_size 个监听 socket, 成功返回 true
+    bool AttachReusePortCpuFilter(int group_size);
+
 public:
     // 返回 sockfd_
     int sockfd() const;
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+//
+#include <cutemuduo/callbacks.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/noncopyable.hpp>
+
+namespace cutemuduo {
+
+class Connector;
+class EventLoop;
+
+// TCP 客户端: 在 loop 上主动连接 server_addr(见 Connector), 连接成功后得到与 TcpServer 相同的 TcpConnection,
+// 使用相同的回调(连接建立/断开、收到消息、发送完成); 同一时间最多一个连接
+// 开启自动重连(SetAutoReconnect)后连接断开时重新连接, 重试间隔指数退避(连接保持一段时间后才重置, 见 Connector::Restart)
+//
+// 用法:
+//   TcpClient client(&loop, InetAddress(9012, "127.0.0.1"), "EchoClient");
+//   client.SetConnectionCallback([](TcpConnectionPtr const& conn) { if (conn->IsConnected()) conn->Send("hi"); });
+//   client.SetMessageCallback(...);
+//   client.SetAutoReconnect(true);
+//   client.Connect();
+class TcpClient : NonCopyable {
+public:
+    TcpClient(EventLoop* loop, InetAddress const& server_addr, std::string const& name);
+
+    // NOTE: 需在 loop 线程中析构; 还在的连接被强制关闭
+    ~TcpClient();
+
+public:
+    // NOTE: 以下回调需在 Connect 之前设置, 在 loop 线程中调用
+
+    // **用户自定义设置** 连接建立/断开后的回调函数
+    void SetConnectionCallback(ConnectionCallback cb) { connection_callback_ = std::move(cb); }
+
+    // **用户自定义设置** 收到消息后的回调函数
+    void SetMessageCallback(MessageCallback cb) { message_callback_ = std::move(cb); }
+
+    // **用户自定义设置** 发送完消息后的回调函数
+    void SetWriteCompleteCallback(WriteCompleteCallback cb) { write_complete_callback_ = std::move(cb); }
+
+    // 连接断开后是否自动重连(默认不重连)
+    void SetAutoReconnect(bool on) { auto_reconnect_ = on; }
+
+    // 设置连接失败时的重试间隔(初始值和上限, 见 Connector)
+    void SetRetryDelay(std::chrono::milliseconds initial, std::chrono::milliseconds max);
+
+public:
+    // 开始连接(线程安全); 已经有连接时不做任何事, 连接关闭之后(包括 Disconnect/Stop 之后)再次调用会建立新的连接
+    void Connect();
+
+    // 关闭当前连接的写端(线程安全), 不再自动重连
+    void Disconnect();
+
+    // 停止正在进行的连接/重试(线程安全), 不影响已经建立的连接
+    void Stop();
+
+    // 当前连接(没有连接时为空, 线程安全)
+    TcpConnectionPtr connection() const;
+
+    EventLoop* GetLoop() const { return loop_; }
+
+    std::string const& name() const { return name_; }
+
+private:
+    // Connector 连接成功(在 loop 线程中)
+    void NewConnection(int sockfd);
+
+    // 连接关闭(在 loop 线程中)
+    void RemoveConnection(TcpConnectionPtr const& conn_ptr);
+
+    EventLoop* loop_;
+    std::shared_ptr<Connector> connector_;
+    std::string const name_;
+    std::shared_ptr<std::string const> conn_name_prefix_;  // 连接名称前缀("名称-服务端地址")
+
+    ConnectionCallback connection_callback_;         // 连接建立/断开后的回调函数
+    MessageCallback message_callback_;               // 收到消息后的回调函数
+    WriteCompleteCallback write_complete_callback_;  // 发送完消息后的回调函数
+
+    std::atomic<bool> auto_reconnect_;  // 连接断开后是否自动重连
+    std::atomic<bool> connect_;         // 是否需要连接(Disconnect/Stop 之后为 false)
+    uint64_t next_conn_id_;             // 下一个连接 ID(只在 loop 线程中访问)
+
+    mutable std::mutex mutex_;
+    TcpConnectionPtr connection_;  // 当前连接(mutex_ 保护)
+};
+
+}  // namespace cutemuduo
@@ -2,42 +2,49 @@
 
 #include <any>
 #include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 //
 #include <cutemuduo/buffer.hpp>
 #include <cutemuduo/callbacks.hpp>
+#include <cutemuduo/channel.hpp>
 #include <cutemuduo/inet_address.hpp>
 #include <cutemuduo/noncopyable.hpp>
+#include <cutemuduo/socket.hpp>
 #include <cutemuduo/timestamp.hpp>
 
 namespace cutemuduo {
 
 class EventLoop;
-class Channel;
-class Socket;
+class ReadAwaiter;
+class WriteAwaiter;
 
-class TcpConnection : NonCopyable, public std::enable_shared_from_this<TcpConnection> {
+// NOTE: TcpConnection 作为内嵌 Channel 的 ChannelHandler, 事件直接分发到 HandleRead 等成员函数;
+// 生命周期: 连接表(或 ConnectDestroyed 任务)持有最后一个引用, ConnectDestroyed 先从 Poller 中移除 Channel
+class TcpConnection : NonCopyable, public std::enable_shared_from_this<TcpConnection>, private ChannelHandler {
 public:
-    TcpConnection(EventLoop* loop, std::string const& name_arg, int sockfd, InetAddress const& localAddr,
-                  InetAddress const& peerAddr);
+    // id: 连接 ID(同一个 TcpServer 内唯一), name_prefix: 连接名称前缀, 名称为 "前缀#ID"
+    TcpConnection(EventLoop* loop, uint64_t id, std::shared_ptr<std::string const> name_prefix, int sockfd,
+                  InetAddress const& localAddr, InetAddress const& peerAddr);
 
     // 析构函数( TODO: **不能在内部调用 ConnectDestroyed** )
     // 正在析构的对象捕获 [this] 危险, 且如果调用 loop_->RunInLoop 不能保证 loop_ 还存在
     ~TcpConnection();
 
 private:
-    // 绑定 Channel 的可读回调函数
-    void HandleRead(Timestamp receive_time);
+    // Channel 可读事件
+    void HandleRead(Timestamp receive_time) override;
 
-    // 绑定 Channel 的可写回调函数
-    void HandleWrite();
+    // Channel 可写事件
+    void HandleWrite() override;
 
-    // 绑定 Channel 的关闭回调函数
-    void HandleClose();
+    // Channel 关闭事件
+    void HandleClose() override;
 
-    // 绑定 Channel 的错误回调函数
-    void HandleError();
+    // Channel 错误事件
+    void HandleError() override;
 
 public:
     // 设置用户自定义的 **连接建立后** 的回调函数(由上层 TcpServer 调用)
@@ -59,12 +66,31 @@ public:
     // 向对端发送消息(std::string)
     void Send(std::string const& msg);
 
+    // 向对端发送消息(std::string, 跨线程时直接移动进任务, 避免拷贝)
+    void Send(std::string&& msg);
+
     // 向对端发送消息(Buffer)
     void Send(Buffer* buffer);
 
     // 在当前连接所属的 EventLoop 线程中发送消息
     void SendInLoop(void const* data, size_t len);
 
+public:
+    // =================== 协程(见 coroutine.hpp, 只能在连接所属的 loop 线程中 co_await) ===================
+    // NOTE: 一旦有协程读取本连接, 收到数据后不再调用 message_callback_, 数据留在输入缓冲区等协程读取
+
+    // co_await conn->Read(n): 读取 n 字节
+    ReadAwaiter Read(size_t n);
+
+    // co_await conn->ReadUntil(delim): 读取到 delim 为止(包含 delim)
+    ReadAwaiter ReadUntil(std::string delim);
+
+    // co_await conn->Write(data): 发送 data, 全部写入内核后恢复
+    WriteAwaiter Write(std::string const& data);
+
+    // co_await conn->Write(buffer): 发送并清空 buffer, 全部写入内核后恢复
+    WriteAwaiter Write(Buffer* buffer);
+
 public:
     // 当 **TcpServer** 接受到新连接时调用
     void ConnectEstablished();
@@ -78,11 +104,27 @@ public:
     // 在 EventLoop 线程中关闭连接
     void ShutdownInLoop();
 
+    // 优雅关闭(线程安全): 已经到达的数据先交给上层, 然后不再读, 输出缓冲区(经 HandleWrite)发送完毕后关闭连接
+    // NOTE: 空闲连接(没有未读数据, 输出缓冲区为空)立即关闭, 但还没收到过数据的新连接要等第一个请求处理完;
+    // 对端一直不发送/不接收时由调用者在超时后 ForceClose
+    // (见 TcpServer::Stop); 上层在 IsDraining 时可以在响应中通知对端关闭(例如 HTTP 的 Connection: close)
+    void DrainAndClose();
+
+    // 立即关闭连接(线程安全), 丢弃输出缓冲区中未发送的数据
+    void ForceClose();
+
+    // 设置 TCP_NODELAY(禁用 Nagle 算法, 小请求/响应立即发送)
+    void SetTcpNoDelay(bool on);
+
 public:
     // 获取当前连接所属的 EventLoop
     EventLoop* GetLoop() const;
 
+    // 获取当前连接的 ID
+    uint64_t id() const { return id_; }
+
     // 获取当前连接的名称
+    // NOTE: 第一次调用时才格式化(线程安全), 热路径上请用 id()
     std::string const& GetName() const;
 
     // 获取当前连接的本地地址信息
@@ -94,6 +136,9 @@ public:
     // 判断当前连接是否已经建立
     bool IsConnected() const;
 
+    // 是否正在优雅关闭(见 DrainAndClose, 只在 loop 线程中调用)
+    bool IsDraining() const { return draining_; }
+
     void SetContext(std::any const& context) { context_ = context; };
 
     std::any const& GetContext() const { return context_; }
@@ -112,14 +157,29 @@ private:
 
     void SetState(StateE const& new_s);
 
-private:
-    EventLoop* loop_;            // 所属 **Sub** EventLoop
-    std::string name_;           // 连接名称
-    std::atomic<StateE> state_;  // 连接状态
-    bool reading_;               // 是否正在监听读事件
+    // 连接关闭/销毁时恢复所有挂起的协程(它们会看到连接已断开)
+    void ResumeWaiters();
 
-    std::unique_ptr<Socket> socket_;    // 已经连接的 socketfd
-    std::unique_ptr<Channel> channel_;  // socketfd 对应的 Channel
+    // 优雅关闭的最后一步: 不再读, 输出缓冲区发送完毕后关闭(见 DrainAndClose)
+    void FinishDraining();
+
+    friend class ReadAwaiter;
+    friend class WriteAwaiter;
+
+private:
+    EventLoop* loop_;                                 // 所属 **Sub** EventLoop
+    uint64_t id_;                                     // 连接 ID
+    std::shared_ptr<std::string const> name_prefix_;  // 连接名称前缀(同一个 TcpServer 的连接共享)
+    mutable std::once_flag name_once_;                // 名称只格式化一次
+    mutable std::string name_;                        // 连接名称(GetName 时才格式化)
+    std::atomic<StateE> state_;                       // 连接状态
+    bool reading_;                                    // 是否正在监听读事件
+    bool draining_;                                   // 是否正在优雅关闭(见 DrainAndClose)
+    bool received_;                                   // 是否收到过数据(DrainAndClose 时没收到过的连接等第一个请求)
+
+    // NOTE: Socket/Channel 直接内嵌, 和 TcpConnection 在同一块内存里(见 TcpServer::CreateConnection)
+    Socket socket_;    // 已经连接的 socketfd
+    Channel channel_;  // socketfd 对应的 Channel
 
     InetAddress local_addr_;  // 服务器地址信息
     InetAddress peer_addr_;   // 客户端地址信息
@@ -139,6 +199,10 @@ private:
     Buffer output_buffer_;  // 该 TCP 连接对应的 **用户** 输出缓冲区
 
     std::any context_;
+
+    ReadAwaiter* read_waiter_;    // 正在等待输入的协程(同一时刻最多一个)
+    WriteAwaiter* write_waiter_;  // 正在等待输出缓冲区清空的协程(同一时刻最多一个)
+    bool coroutine_reading_;      // 是否有协程读取过本连接
 };
 
 }  // namespace cutemuduo
@@ -1,25 +1,41 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <future>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 //
+#include <cutemuduo/acceptor.hpp>
 #include <cutemuduo/callbacks.hpp>
+#include <cutemuduo/cpu_affinity.hpp>
+#include <cutemuduo/dispatch_policy.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/timer_queue.hpp>
+#include <cutemuduo/token_bucket.hpp>
 
 namespace cutemuduo {
 
 class EventLoop;
-class InetAddress;
-class Acceptor;
 class EventLoopThreadPool;
 
 class TcpServer {
 public:
     using ThreadInitCallback = std::function<void(EventLoop*)>;
 
-    enum class Option { kNoReusePort, kReusePort };
+    // 停止完成回调(在 Mainloop 中调用), drained 为 false 表示有连接在超时后被强制关闭
+    using StopCallback = std::function<void(bool drained)>;
 
+    // - kNoReusePort: 单个 Acceptor(Mainloop)
+    // - kReusePort: 单个 Acceptor(Mainloop), 监听 socket 设置 SO_REUSEPORT(多个进程可以监听同一端口)
+    // - kReusePortPerLoop: 每个 Subloop 一个 SO_REUSEPORT 监听 socket, 由内核把新连接分散到各个 Subloop,
+    //   在哪个 Subloop 上 accept 就在哪个 Subloop 上服务, 不再经过 Mainloop 转交(线程数为 0 时同 kReusePort)
+    //   (监听 Unix 域 socket 时同 kNoReusePort)
+    enum class Option { kNoReusePort, kReusePort, kReusePortPerLoop };
+
+    // listen_addr 可以是 IPv4/IPv6 地址或 Unix 域 socket 地址(InetAddress::UnixPath / UnixAbstract)
     TcpServer(EventLoop* loop, InetAddress const& listen_addr, std::string const& name,
               Option const& option = Option::kNoReusePort);
 
@@ -46,15 +62,121 @@ public:
     // 设置底层 Subloop 个数(不包括 Baseloop(即 Mainloop))
     void SetThreadNum(int num_threads);
 
+    // 设置 Subloop 线程的 CPU 绑定方式(见 cpu_affinity.hpp), 需在 Start() 之前调用
+    void SetCpuAffinity(CpuAffinity affinity);
+
+    // kReusePortPerLoop 模式下, 用 cBPF 程序按处理 SYN 的 CPU 选择监听 socket(CPU c -> 第 c % 线程数 个 Subloop)
+    // 配合 SetCpuAffinity(CpuAffinity::CpuList({0, 1, ...})) 使用, 连接从网卡中断到业务处理都在同一个核上
+    // 需在 Start() 之前调用
+    void SetReusePortCpuSteering(bool on);
+
+    // 设置新连接分配到 Subloop 的策略(默认轮询, 见 dispatch_policy.hpp), 需在 Start() 之前调用
+    // NOTE: kReusePortPerLoop 模式下由内核选择 Subloop, 不使用该策略
+    void SetDispatchPolicy(std::unique_ptr<DispatchPolicy> policy);
+
+    // 设置 Acceptor 每次可读事件最多 accept 的连接数(默认 Acceptor::kDefaultAcceptBatch), 需在 Start() 之前调用
+    void SetAcceptBatch(int batch);
+
+    // =================== 准入控制(需在 Start() 之前调用) ===================
+    // NOTE: 故障转移后的重连风暴中, accept 得比处理得快(TLS 握手、鉴权), 先限住入口
+
+    // 限制新连接的速率(令牌桶): 平均每秒最多 rate 个, 允许 burst 个突发(rate <= 0 表示不限制)
+    void SetConnectionRateLimit(double rate, double burst);
+
+    // 限制同时存在的连接数(0 表示不限制)
+    void SetMaxConnections(size_t max_connections);
+
+    // 超过上面两个限制时的处理方式(默认暂停 accept, 见 Acceptor::OverloadAction)
+    void SetOverloadAction(Acceptor::OverloadAction action);
+
+    // =================== 热重启(见 hot_restart.hpp) ===================
+
+    // 新进程: 接管旧进程交来的监听 socket, 不再创建/绑定新的 socket; 需在 Start() 之前调用
+    // 按顺序分给 Acceptor(kReusePortPerLoop 时每个 Subloop 一个, 前后 Subloop 数量应当一致)
+    void AdoptListenSockets(std::vector<int> fds);
+
+    // 旧进程: 当前所有监听 socket 的 fd(Start() 之后, Stop() 之前调用)
+    std::vector<int> listen_fds() const;
+
+    // 旧进程: 监听 socket 已经交给新进程, 之后 Stop 只停止本进程的 accept, 不 shutdown 监听 socket
+    void MarkListenSocketsHandedOff();
+
     // 启动服务器(开启监听)
     void Start();
 
+    // 优雅停止(线程安全):
+    // 1. 停止 Acceptor, 不再接受新连接
+    // 2. 每个连接进入优雅关闭(TcpConnection::DrainAndClose): 已经到达的请求照常处理, 然后不再读,
+    //    响应发送完毕后关闭(空闲连接立即关闭, 还没收到过数据的新连接等第一个请求)
+    // 3. 超过 timeout 仍未关闭的连接被强制关闭
+    // 4. 所有连接销毁后退出所有 Subloop, 然后调用 cb
+    // NOTE: Mainloop 不会退出, 由用户决定(例如在 cb 中调用 loop->Quit())
+    // NOTE: 调用 Stop 之后, 要等 cb 被调用才能析构 TcpServer
+    void Stop(std::chrono::milliseconds timeout, StopCallback cb);
+
+    // 同上, 通过 future 得到结果
+    // NOTE: 不要在 Mainloop 线程中等待这个 future(停止流程需要 Mainloop 运行)
+    std::future<bool> Stop(std::chrono::milliseconds timeout);
+
 private:
+    // 每个 loop 一份的连接表(只在所属的 loop 线程中访问)
+    struct ConnectionShard;
+
+    // Mainloop 上的 Acceptor accept 到新连接: 按分配策略选择 Subloop, 在该 Subloop 上构造、登记并建立连接
     void NewConnection(int sockfd, InetAddress const& peer_addr);
 
-    void RemoveConnection(TcpConnectionPtr const& conn);
+    // kReusePortPerLoop: 在 shard 所属的 Subloop 上 accept 到新连接, 直接在该 loop 上登记并建立连接
+    void NewConnectionInLoop(ConnectionShard* shard, int sockfd, InetAddress const& peer_addr);
+
+    // 在 shard 所属的 loop 线程中构造、登记并建立连接(连接数已经计入)
+    void NewConnectionInShard(ConnectionShard* shard, int sockfd, InetAddress const& peer_addr);
+
+    // 构造 TcpConnection 并设置回调(在 shard 所属的 loop 线程中调用)
+    TcpConnectionPtr CreateConnection(ConnectionShard* shard, int sockfd, InetAddress const& peer_addr);
+
+    // kReusePortPerLoop: 在每个 Subloop 上创建 Acceptor 并依次开始监听
+    void StartLoopAcceptors();
 
-    void RemoveConnectionInLoop(TcpConnectionPtr const& conn);
+    // 创建 io_loop 上的 Acceptor: 优先接管 AdoptListenSockets 交来的监听 socket
+    std::unique_ptr<Acceptor> CreateAcceptor(EventLoop* io_loop, bool reuse_port);
+
+    // 设置 Acceptor 的批量大小、准入检查和计数
+    void ConfigureAcceptor(Acceptor* acceptor);
+
+    // 准入检查(见 Acceptor::AdmissionCallback, 可能在多个 Acceptor 的线程中同时调用)
+    std::chrono::nanoseconds CheckAdmission() const;
+
+    // 新连接分配到 io_loop 时: 计入连接数并取走一个令牌
+    void AdmitConnection(EventLoop* io_loop);
+
+    // io_loop 对应的连接表
+    ConnectionShard* ShardOf(EventLoop* io_loop) const;
+
+    // 以下均在 shard 所属的 loop 线程中执行
+    void RegisterConnectionInLoop(ConnectionShard* shard, TcpConnectionPtr const& conn);
+
+    void RemoveConnectionInLoop(ConnectionShard* shard, TcpConnectionPtr const& conn);
+
+    // 停止 shard 上的 Acceptor 并优雅关闭 shard 上的所有连接
+    void StopShardInLoop(ConnectionShard* shard);
+
+    // shard 上所有连接的副本
+    // NOTE: 在 loop 线程中关闭连接会同步地从 shard 中移除它, 不能边遍历连接表边关闭
+    static std::vector<TcpConnectionPtr> SnapshotConnections(ConnectionShard* shard);
+
+    // shard 正在停止且连接表已经清空: 等排在前面的 ConnectDestroyed 执行完后通知 Mainloop
+    void TryFinishShardStop(ConnectionShard* shard);
+
+    // 析构时: 在 shard 所属的 loop 线程中销毁 shard 并等待完成; 该 loop 不在事件循环中时直接在当前线程中销毁
+    static void TeardownShard(ConnectionShard* shard);
+
+    // 销毁 shard 上的 Acceptor 和所有连接, 之后 shard 上不再有回调访问 TcpServer
+    static void TeardownShardInLoop(ConnectionShard* shard);
+
+    void StopInLoop(std::chrono::milliseconds timeout, StopCallback cb);
+
+    // 所有 shard 都已停止时: 退出 Subloop 并通知用户
+    void TryFinishStop();
 
 public:
     std::string name() const { return name_; }
@@ -63,15 +185,30 @@ public:
 
     EventLoop* loop() const { return loop_; }
 
+    // 当前连接数(任何线程都可以调用)
+    size_t connections() const { return num_connections_.load(std::memory_order_relaxed); }
+
+    // 因 fd 耗尽/超过准入限制而丢弃的连接计数(任何线程都可以读)
+    AcceptorCounters const& acceptor_counters() const { return *acceptor_counters_; }
+
+    // 线程池(可用于获取所有 Subloop 及其运行时统计)
+    std::shared_ptr<EventLoopThreadPool> thread_pool() const { return thread_pool_; }
+
 private:
-    using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
+    using ConnectionMap = std::unordered_map<uint64_t, TcpConnectionPtr>;  // 连接 ID -> 连接
 
     EventLoop* loop_;  // **Mainloop** 用户自定义
 
     std::string ip_port_;  // 服务器 IP 地址和端口号
     std::string name_;     // 服务器名称
 
-    std::unique_ptr<Acceptor> acceptor_;
+    InetAddress listen_addr_;  // 监听地址
+    Option option_;
+
+    std::unique_ptr<Acceptor> acceptor_;  // Mainloop 上的 Acceptor(Start 时创建, kReusePortPerLoop 时为空)
+    bool cpu_steering_;                   // kReusePortPerLoop: 是否按 CPU 选择监听 socket
+    int accept_batch_;                    // 每次可读事件最多 accept 的连接数
+    std::vector<int> adopted_fds_;        // 热重启: 还没有被 Acceptor 接管的监听 socket
 
     std::shared_ptr<EventLoopThreadPool> thread_pool_;  // 线程池
 
@@ -84,8 +221,33 @@ private:
     ThreadInitCallback thread_init_callback_;  // **用户自定义** 线程初始化回调函数(默认为空)
     int num_threads_;                          // 线程数量(其实就是 Subloop 个数(不包括 Mainloop))
     std::atomic_int started_;                  // 服务器是否已经启动(用 int 判断防止 TcpServer **启动多次**)
-    int next_conn_id_;                         // 下一个连接的 ID
-    ConnectionMap connections_;                // 保存的所有连接
+
+    // NOTE: 连接用 64 位 ID 标识, 名称("服务器名-ip:port#ID")只在 TcpConnection::GetName() 时才格式化
+    std::shared_ptr<std::string const> conn_name_prefix_;  // 连接名称前缀(所有连接共享)
+    std::atomic<uint64_t> next_conn_id_;                   // 下一个连接的 ID(kReusePortPerLoop 时多个 Subloop 同时分配)
+
+    // NOTE: 连接表按 loop 分片, 连接的登记/移除都在所属的 loop 中完成, 不再经过 Mainloop 来回转交
+    std::vector<std::unique_ptr<ConnectionShard>> shards_;  // 下标与 GetAllLoops() 一致(Start 之后不再变化)
+
+    // =================== 准入控制 ===================
+    size_t max_connections_;                               // 最大并发连接数(0 表示不限制)
+    std::unique_ptr<TokenBucket> rate_limiter_;            // 新连接速率限制(为空表示不限制)
+    Acceptor::OverloadAction overload_action_;             // 超过限制时的处理方式
+    std::atomic<size_t> num_connections_;                  // 当前连接数
+    std::shared_ptr<AcceptorCounters> acceptor_counters_;  // 所有 Acceptor 共享的计数
+
+    // =================== 优雅停止(只在 Mainloop 中访问) ===================
+    bool stopping_;               // 是否正在停止
+    size_t shards_stopping_;      // 还没停止完的 shard 数
+    bool stopped_;                // 已经开始退出 Subloop(只执行一次)
+    bool drained_;                // 是否所有连接都正常关闭(没有超时)
+    TimerId stop_timer_;          // 超时定时器
+    StopCallback stop_callback_;  // 停止完成回调
+
+    // 析构时 reset: 投递到 loop 中、捕获了 this 的任务通过 weak_ptr 检查 TcpServer 是否还存在
+    // NOTE: Mainloop 上的任务与析构函数在同一个线程中, 检查之后不会被并发析构;
+    // Subloop 上的任务排在析构函数投递的销毁任务之前, 析构函数会等它们执行完(见 TeardownShard)
+    std::shared_ptr<bool> alive_;
 };
 
 }  // namespace cutemuduo
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+//
+#include <cutemuduo/noncopyable.hpp>
+#include <cutemuduo/unique_function.hpp>
+
+namespace cutemuduo {
+
+class Channel;
+class EventLoop;
+
+// 定时器 ID(用于取消), seq == 0 表示无效
+struct TimerId {
+    uint64_t seq = 0;
+};
+
+// 基于 timerfd 的定时器队列, 每个 EventLoop 一个
+// NOTE: 定时器按 (到期时间, 序号) 排序保存在 std::map 中, timerfd 只设置为最早的到期时间;
+// 到期回调在 loop 线程中执行
+class TimerQueue : NonCopyable {
+public:
+    using Clock = std::chrono::steady_clock;  // 与 timerfd 的 CLOCK_MONOTONIC 一致
+    using TimerCallback = UniqueFunction<void()>;
+
+    explicit TimerQueue(EventLoop* loop);
+
+    ~TimerQueue();
+
+public:
+    // 添加定时器: when 到期执行 cb, interval > 0 时之后每隔 interval 重复执行(线程安全)
+    TimerId AddTimer(TimerCallback cb, Clock::time_point when, Clock::duration interval);
+
+    // 取消定时器(线程安全), 已经执行过的一次性定时器忽略; 可以在定时器回调中取消自身
+    void Cancel(TimerId id);
+
+private:
+    void AddTimerInLoop(uint64_t seq, TimerCallback cb, Clock::time_point when, Clock::duration interval);
+
+    void CancelInLoop(uint64_t seq);
+
+    // timer_channel_ 的读回调: 执行所有到期的定时器
+    void HandleRead();
+
+    // 把 timerfd 设置为最早的到期时间(没有定时器时停止)
+    void ResetTimerfd();
+
+private:
+    struct Timer {
+        TimerCallback cb;
+        Clock::duration interval;  // 重复间隔(0: 一次性)
+    };
+
+    using Key = std::pair<Clock::time_point, uint64_t>;  // (到期时间, 序号)
+
+    EventLoop* loop_;
+    int timerfd_;
+    std::unique_ptr<Channel> timer_channel_;
+
+    std::map<Key, Timer> timers_;                               // 按到期时间排序的定时器
+    std::unordered_map<uint64_t, Clock::time_point> deadlines_;  // 序号 -> 到期时间(用于取消)
+    std::atomic<uint64_t> next_seq_;
+
+    Clock::time_point armed_;  // 当前 timerfd 设置的到期时间
+    uint64_t running_seq_;     // 正在执行回调的定时器(0: 没有)
+    bool running_canceled_;    // 正在执行的定时器在回调中被取消
+};
+
+}  // namespace cutemuduo
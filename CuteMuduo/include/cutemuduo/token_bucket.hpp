@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+//
+#include <cutemuduo/noncopyable.hpp>
+
+namespace cutemuduo {
+
+// 令牌桶限速器: 每秒产生 rate 个令牌, 最多积攒 burst 个(线程安全, 无锁)
+// NOTE: 用 GCRA(虚拟调度)实现, 与令牌桶等价: 只保存一个"理论到达时间" tat_,
+// 每取走一个令牌 tat_ 向后推一个间隔; tat_ 领先当前时间不超过 (burst - 1) 个间隔时就有令牌可用
+class TokenBucket : NonCopyable {
+public:
+    TokenBucket(double rate, double burst);
+
+    // 还要多久才有令牌可用(0 表示现在就有)
+    std::chrono::nanoseconds Delay() const;
+
+    // 取走一个令牌, 没有令牌时透支(之后的 Delay 相应变长)
+    void Consume();
+
+private:
+    static int64_t NowNs();
+
+    int64_t interval_ns_;          // 产生一个令牌的间隔
+    int64_t tolerance_ns_;         // tat_ 最多领先当前时间多少(即 burst - 1 个间隔)
+    std::atomic<int64_t> tat_ns_;  // 理论到达时间
+};
+
+}  // namespace cutemuduo
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cutemuduo {
+
+// 只能移动的函数包装器(类似 C++23 std::move_only_function), 带 64 字节内联缓冲区
+//
+// 与 std::function 的区别:
+// - 可以保存只能移动的可调用对象(如捕获了 std::unique_ptr 的 lambda)
+// - 捕获不超过 kInlineSize 字节的 lambda 直接放在对象内部, 不分配堆内存
+//   (std::function 在 libstdc++ 中只能内联两个指针大小的捕获, 捕获一个 std::string 就会堆分配)
+// - 不可拷贝
+template <typename Signature>
+class UniqueFunction;
+
+template <typename R, typename... Args>
+class UniqueFunction<R(Args...)> {
+public:
+    static constexpr size_t kInlineSize = 64;  // 内联缓冲区大小
+
+    UniqueFunction() noexcept = default;
+
+    UniqueFunction(std::nullptr_t) noexcept {}
+
+    template <typename F, typename D = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<D, UniqueFunction> && std::is_invocable_r_v<R, D&, Args...>>>
+    UniqueFunction(F&& f) {
+        if constexpr (kFitsInline<D>) {
+            ::new (static_cast<void*>(storage_)) D(std::forward<F>(f));
+            ops_ = &kInlineOps<D>;
+        } else {
+            *reinterpret_cast<D**>(storage_) = new D(std::forward<F>(f));
+            ops_ = &kHeapOps<D>;
+        }
+    }
+
+    UniqueFunction(UniqueFunction&& other) noexcept : ops_(other.ops_) {
+        if (ops_) {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            if (other.ops_) {
+                other.ops_->move(storage_, other.storage_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    UniqueFunction(UniqueFunction const&) = delete;
+    UniqueFunction& operator=(UniqueFunction const&) = delete;
+
+    ~UniqueFunction() { Reset(); }
+
+public:
+    R operator()(Args... args) { return ops_->invoke(storage_, std::forward<Args>(args)...); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    // 销毁保存的可调用对象, 之后为空
+    void Reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    // 手写的"虚函数表": 每种可调用类型 F 对应一份静态的 Ops
+    struct Ops {
+        R (*invoke)(void* storage, Args&&... args);
+        void (*move)(void* dst, void* src) noexcept;  // 移动到 dst 并销毁 src
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    // NOTE: 移动构造可能抛异常的类型放到堆上, 保证 UniqueFunction 自身的移动是 noexcept
+    template <typename F>
+    static constexpr bool kFitsInline = sizeof(F) <= kInlineSize && alignof(F) <= alignof(std::max_align_t) &&
+                                        std::is_nothrow_move_constructible_v<F>;
+
+    template <typename F>
+    static F* InlinePtr(void* storage) {
+        return std::launder(reinterpret_cast<F*>(storage));
+    }
+
+    template <typename F>
+    static F*& HeapPtr(void* storage) {
+        return *reinterpret_cast<F**>(storage);
+    }
+
+    template <typename F>
+    static constexpr Ops kInlineOps{
+        [](void* s, Args&&... args) -> R { return (*InlinePtr<F>(s))(std::forward<Args>(args)...); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) F(std::move(*InlinePtr<F>(src)));
+            InlinePtr<F>(src)->~F();
+        },
+        [](void* s) noexcept { InlinePtr<F>(s)->~F(); },
+    };
+
+    template <typename F>
+    static constexpr Ops kHeapOps{
+        [](void* s, Args&&... args) -> R { return (*HeapPtr<F>(s))(std::forward<Args>(args)...); },
+        [](void* dst, void* src) noexcept { HeapPtr<F>(dst) = HeapPtr<F>(src); },
+        [](void* s) noexcept { delete HeapPtr<F>(s); },
+    };
+
+private:
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];  // 内联缓冲区(或指向堆上对象的指针)
+    Ops const* ops_ = nullptr;
+};
+
+}  // namespace cutemuduo
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+//
+#include <cutemuduo/callbacks.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/noncopyable.hpp>
+#include <cutemuduo/timer_queue.hpp>
+#include <cutemuduo/unique_function.hpp>
+
+namespace cutemuduo {
+
+class Buffer;
+class EventLoop;
+class TcpClient;
+
+// UpstreamPool 的配置
+struct UpstreamPoolOptions {
+    size_t connections = 4;                                // 常驻连接数
+    size_t max_pending_per_connection = 64;                // 每个连接最多的在途请求数
+    size_t max_waiting = 1024;                             // 所有连接都满时最多排队的请求数
+    std::chrono::milliseconds request_timeout{1000};       // 请求超时
+    std::chrono::milliseconds health_check_interval{500};  // 健康检查间隔
+    std::string probe_request;                             // 空闲连接的探测请求(为空表示不探测)
+    std::chrono::milliseconds initial_retry_delay{100};    // 重连的初始间隔
+    std::chrono::milliseconds max_retry_delay{10 * 1000};  // 重连的最大间隔
+};
+
+// 上游连接池: 一个 EventLoop 上到一个上游(后端)的 N 个常驻连接(TcpClient, 断线自动重连)
+// NOTE: one loop per thread, 每个 loop 一个池, 只在所属 loop 线程中使用, 取连接/发请求都不加锁, 也不跨线程转交;
+// 代理类服务在 TcpServer::SetThreadInitCallback 中为每个 Subloop 创建自己的池, 连接的处理直接在本 loop 上转发
+//
+// 请求复用(pipelining): 每个连接上可以同时有多个在途请求, 响应按发送顺序返回(HTTP/1.1 pipelining, Redis 等),
+// 收到的数据由 ResponseFramer 切分成一个个响应, 依次交给最早的在途请求; 新请求交给在途请求最少的连接
+//
+// 健康检查(每隔 health_check_interval):
+// - 最早的在途请求超过 request_timeout 没有响应: 之后的响应都无法对应, 该连接上的请求全部失败, 连接被关闭并重连
+// - 设置了 probe_request 时, 空闲超过 health_check_interval 的连接发送一次探测请求, 超时同样关闭重连
+// - 没有可用连接(都在重连)时新请求排队等待, 超过 request_timeout 失败
+//
+// 用法(按行协议):
+//   UpstreamPool pool(loop, InetAddress(6379, "127.0.0.1"), "redis", [](Buffer const* buf) -> ssize_t {
+//       char const* crlf = buf->FindCRLF();
+//       return crlf ? crlf + 2 - buf->Peek() : 0;
+//   });
+//   pool.Start();
+//   pool.Request("PING\r\n", [](bool ok, std::string_view response) { ... });
+class UpstreamPool : NonCopyable {
+public:
+    // 从输入缓冲区开头切出一个完整的响应: 返回响应长度, 0 表示还不完整, < 0 表示协议错误(连接被关闭并重连)
+    using ResponseFramer = std::function<ssize_t(Buffer const* buf)>;
+
+    // 请求完成(在 loop 线程中调用): ok 为 false 表示失败(超时/连接断开/没有可用连接), response 为空
+    // NOTE: response 指向连接的输入缓冲区, 只在回调期间有效
+    using ResponseCallback = UniqueFunction<void(bool ok, std::string_view response)>;
+
+    using Options = UpstreamPoolOptions;
+
+    // 统计(只在 loop 线程中读)
+    struct Stats {
+        uint64_t completed = 0;  // 成功的请求(不含探测请求)
+        uint64_t failed = 0;     // 失败的请求(不含探测请求)
+        uint64_t evicted = 0;    // 因超时/协议错误被关闭的连接
+    };
+
+    UpstreamPool(EventLoop* loop, InetAddress const& upstream, std::string const& name, ResponseFramer framer,
+                 Options options = Options());
+
+    // NOTE: 需在 loop 线程中析构; 还没完成的请求以失败回调
+    ~UpstreamPool();
+
+public:
+    // 建立 options.connections 个连接(线程安全)
+    void Start();
+
+    // 发送一个请求(只能在 loop 线程中调用), 完成或失败时调用 cb
+    void Request(std::string_view request, ResponseCallback cb);
+
+    // 已经建立的连接数
+    size_t connected() const;
+
+    // 在途 + 排队的请求数
+    size_t pending() const;
+
+    Stats const& stats() const { return stats_; }
+
+    EventLoop* GetLoop() const { return loop_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingRequest {
+        ResponseCallback cb;
+        Clock::time_point deadline;
+    };
+
+    struct WaitingRequest {
+        std::string request;
+        ResponseCallback cb;
+        Clock::time_point deadline;
+    };
+
+    struct Slot {
+        std::unique_ptr<TcpClient> client;
+        TcpConnectionPtr conn;               // 已经建立的连接(断开时为空)
+        std::deque<PendingRequest> pending;  // 在途请求(按发送顺序)
+        Clock::time_point last_active;       // 最近一次发送/收到响应的时间
+    };
+
+    void OnConnection(Slot* slot, TcpConnectionPtr const& conn_ptr);
+
+    void OnMessage(Slot* slot, Buffer* buf);
+
+    // 在途请求最少且未满的连接(没有时返回 nullptr)
+    Slot* PickSlot();
+
+    void SendOnSlot(Slot* slot, std::string_view request, ResponseCallback cb);
+
+    // 把排队的请求交给有空位的连接
+    void FlushWaiting();
+
+    // 关闭连接(由 TcpClient 自动重连), 在途请求全部失败
+    void Evict(Slot* slot, char const* reason);
+
+    // 在途请求全部失败
+    void FailPending(Slot* slot);
+
+    void Fail(ResponseCallback& cb);
+
+    void HealthCheck();
+
+    EventLoop* loop_;
+    std::string const name_;
+    ResponseFramer framer_;
+    Options const options_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::deque<WaitingRequest> waiting_;  // 没有可用连接时排队的请求
+    TimerId health_timer_;
+    Stats stats_;
+    bool closing_;  // 正在析构: 忽略连接断开等回调
+};
+
+}  // namespace cutemuduo
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+//
+#include <cutemuduo/noncopyable.hpp>
+#include <cutemuduo/thread.hpp>
+
+namespace cutemuduo {
+
+class EventLoop;
+
+// 正在执行的回调所处的阶段
+enum class CallbackPhase : uint8_t {
+    kIdle,     // 没有回调在执行
+    kChannel,  // Channel::HandleEvent(IO 回调)
+    kFunctor,  // DoPendingFunctors 中的任务
+};
+
+char const* CallbackPhaseToString(CallbackPhase phase);
+
+// 看门狗时钟(纳秒)
+// NOTE: 使用 CLOCK_MONOTONIC_COARSE(vDSO 读一个变量, 精度为一个 tick, 约 1~4ms), 远低于慢回调阈值的量级
+inline int64_t WatchdogNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// 每个被监视的 EventLoop 一个槽位: loop 线程写, 看门狗线程读
+// NOTE: 通过 shared_ptr 共享, EventLoop 先析构时看门狗线程读到的仍是有效内存
+struct WatchdogSlot {
+    std::atomic<int64_t> start_ns{0};        // 当前回调开始的时间(0: 空闲)
+    std::atomic<int> fd{-1};                 // 当前回调对应的 fd(kFunctor 时为 -1)
+    std::atomic<CallbackPhase> phase{CallbackPhase::kIdle};
+    std::atomic<int64_t> flagged_start{0};   // 看门狗已报告过的回调的 start_ns(同一个回调只报告一次)
+    std::atomic_bool attached{true};         // EventLoop 析构后置为 false, 看门狗随后丢弃该槽位
+    EventLoop* loop = nullptr;               // 只用于日志
+    pid_t tid = 0;                           // loop 所在线程
+
+    // loop 线程: 回调开始, 三次 relaxed/release store
+    void Begin(CallbackPhase p, int f) {
+        fd.store(f, std::memory_order_relaxed);
+        phase.store(p, std::memory_order_relaxed);
+        start_ns.store(WatchdogNowNs(), std::memory_order_release);
+    }
+
+    // loop 线程: 回调结束, 返回本次回调的耗时(纳秒), 未被看门狗标记为慢回调时返回 0
+    // NOTE: 看门狗线程不读取回调所属的对象(回调结束后它可能随时被析构), 连接名称由这里的调用者在回调结束后记录
+    int64_t End() {
+        int64_t start = start_ns.load(std::memory_order_relaxed);
+        start_ns.store(0, std::memory_order_relaxed);
+        if (flagged_start.load(std::memory_order_relaxed) != start) {
+            return 0;
+        }
+        return WatchdogNowNs() - start;
+    }
+};
+
+// 慢回调看门狗(默认不启用)
+//
+// 被监视的 EventLoop 在每个 Channel 回调和任务执行前后各写几个原子变量(见 WatchdogSlot),
+// 看门狗线程每隔 threshold / 4 扫描一次, 发现某个回调执行超过 threshold 就报告
+// (loop、线程、阶段、fd、已执行时间); 该回调结束时 loop 线程再补一条带连接名称和总耗时的日志
+//
+// 用法:
+//   Watchdog watchdog(std::chrono::milliseconds(100));
+//   watchdog.Start();
+//   server.SetThreadInitCallback([&](EventLoop* loop) { watchdog.Watch(loop); });
+//   watchdog.Watch(&base_loop);
+class Watchdog : NonCopyable {
+public:
+    // 报告给用户的慢回调信息(在看门狗线程中回调, 不持有看门狗的锁)
+    struct SlowCallbackInfo {
+        EventLoop* loop;
+        pid_t tid;
+        CallbackPhase phase;
+        int fd;
+        std::chrono::milliseconds elapsed;
+    };
+
+    using SlowCallbackHandler = std::function<void(SlowCallbackInfo const&)>;
+
+    explicit Watchdog(std::chrono::milliseconds threshold);
+
+    ~Watchdog();
+
+public:
+    // 开始监视 loop(线程安全, 可以在 ThreadInitCallback 中调用); 一个 loop 只能被一个看门狗监视
+    void Watch(EventLoop* loop);
+
+    // 设置慢回调处理函数(默认打 LOG_WARNING), 需在 Start() 之前设置
+    void SetSlowCallbackHandler(SlowCallbackHandler handler);
+
+    // 启动/停止看门狗线程
+    void Start();
+    void Stop();
+
+    // 累计报告的慢回调个数
+    uint64_t slow_callbacks() const;
+
+private:
+    // 看门狗线程执行函数
+    void Run();
+
+    // 扫描一遍所有槽位(持有 mtx_), 返回新发现的慢回调
+    std::vector<SlowCallbackInfo> Scan();
+
+    // 报告慢回调(不持有 mtx_, 用户的处理函数可以调用 Watch 等)
+    void Report(SlowCallbackInfo const& info);
+
+private:
+    std::chrono::milliseconds threshold_;
+    SlowCallbackHandler handler_;
+    std::atomic<uint64_t> slow_callbacks_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool running_;
+    std::vector<std::shared_ptr<WatchdogSlot>> slots_;  // 被 mtx_ 保护
+
+    Thread thread_;
+};
+
+}  // namespace cutemuduo
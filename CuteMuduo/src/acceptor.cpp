@@ -1,36 +1,95 @@
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
+
+#include <algorithm>
 //
 #include <cutemuduo/acceptor.hpp>
+#include <cutemuduo/event_loop.hpp>
 #include <cutemuduo/inet_address.hpp>
 #include <cutemuduo/logger.hpp>
 
 namespace cutemuduo {
 
-static int CreateNonblocking() {
-    int sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+static int CreateNonblocking(sa_family_t family) {
+    // NOTE: 协议填 0, 由地址族决定(AF_INET/AF_INET6 为 TCP, AF_UNIX 为本地流式 socket)
+    int sockfd = socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (sockfd < 0) {
         LOG_FATAL("%s:%s:%d listen socket create err:%d\n", __FILE__, __FUNCTION__, __LINE__, errno);
     }
     return sockfd;
 }
 
+// 需要在析构时删除的 Unix 域 socket 文件路径(其他地址族/抽象命名空间为空)
+static std::string UnixPathOf(InetAddress const& addr) {
+    if (addr.family() != AF_UNIX) {
+        return "";
+    }
+    std::string path = addr.ToIp();
+    return !path.empty() && path[0] == '@' ? "" : path;
+}
+
+static InetAddress LocalAddressOf(int sockfd) {
+    sockaddr_storage local{};
+    socklen_t addrlen = sizeof(local);
+    if (getsockname(sockfd, reinterpret_cast<sockaddr*>(&local), &addrlen) < 0) {
+        LOG_ERROR("%s:%s:%d getsockname err:%d\n", __FILE__, __FUNCTION__, __LINE__, errno);
+        addrlen = 0;
+    }
+    return InetAddress(reinterpret_cast<sockaddr*>(&local), addrlen);
+}
+
 Acceptor::Acceptor(EventLoop* loop, InetAddress const& listen_addr, bool reuse_port)
-    : loop_(loop),
-      accept_socket_(CreateNonblocking()),
-      accept_channel_(loop, accept_socket_.sockfd()),
-      listenning_(false) {
-    accept_socket_.SetReuseAddr(true);        // 地址复用
-    accept_socket_.SetReusePort(reuse_port);  // 端口复用
+    : Acceptor(loop, CreateNonblocking(listen_addr.family()), UnixPathOf(listen_addr)) {
+    if (listen_addr.family() == AF_UNIX) {
+        // NOTE: 文件系统路径的 Unix 域 socket: 删除上次运行残留的 socket 文件, 否则 bind 报 EADDRINUSE
+        // 抽象命名空间('@' 开头)不对应文件; Unix 域 socket 没有端口复用
+        if (!unix_path_.empty()) {
+            ::unlink(unix_path_.c_str());
+        }
+    } else {
+        accept_socket_.SetReuseAddr(true);        // 地址复用
+        accept_socket_.SetReusePort(reuse_port);  // 端口复用
+    }
     accept_socket_.BindAddress(listen_addr);  // 绑定端口和地址
+}
+
+Acceptor::Acceptor(EventLoop* loop, int listen_fd)
+    : Acceptor(loop, listen_fd, UnixPathOf(LocalAddressOf(listen_fd))) {
+    // NOTE: 文件状态标志(O_NONBLOCK)由所有进程中的副本共享, 交出方已经设置过, 这里再确认一次
+    int flags = ::fcntl(listen_fd, F_GETFL);
+    ::fcntl(listen_fd, F_SETFL, flags | O_NONBLOCK);
+    ::fcntl(listen_fd, F_SETFD, FD_CLOEXEC);
+}
 
+Acceptor::Acceptor(EventLoop* loop, int sockfd, std::string unix_path)
+    : loop_(loop),
+      accept_socket_(sockfd),
+      accept_channel_(loop, sockfd),
+      listenning_(false),
+      accept_batch_(kDefaultAcceptBatch),
+      idle_fd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)),
+      overload_action_(OverloadAction::kPauseAccept),
+      counters_(std::make_shared<AcceptorCounters>()),
+      unix_path_(std::move(unix_path)),
+      handed_off_(false) {
+    if (idle_fd_ < 0) {
+        LOG_ERROR("%s:%s:%d open /dev/null err:%d\n", __FILE__, __FUNCTION__, __LINE__, errno);
+    }
     accept_channel_.SetReadCallback([this](Timestamp) { HandleRead(); });  // 注册读回调 EPOLLIN
 }
 
 Acceptor::~Acceptor() {
+    loop_->CancelTimer(resume_timer_);
     accept_channel_.DisableAll();
     accept_channel_.Remove();
+    if (idle_fd_ >= 0) {
+        close(idle_fd_);
+    }
+    if (!unix_path_.empty() && !handed_off_) {
+        ::unlink(unix_path_.c_str());
+    }
 }
 
 bool Acceptor::listening() const {
@@ -43,31 +102,150 @@ void Acceptor::Listen() {
     accept_channel_.EnableReading();  // accept_channel_ 添加读感兴趣事件
 }
 
+void Acceptor::Stop() {
+    if (!listenning_) {
+        return;
+    }
+    listenning_ = false;
+    loop_->CancelTimer(resume_timer_);
+    resume_timer_ = TimerId{};
+    accept_channel_.DisableAll();
+    accept_channel_.Remove();
+    // NOTE: 对监听 socket shutdown 后内核不再完成新的握手(对端收到 RST), fd 本身在析构时关闭
+    // 已经交给其他进程的监听 socket 不能 shutdown(会影响所有进程中的副本), 本进程只是不再 accept
+    if (!handed_off_) {
+        ::shutdown(accept_socket_.sockfd(), SHUT_RDWR);
+    }
+}
+
+void Acceptor::SetHandedOff() {
+    handed_off_ = true;
+}
+
+bool Acceptor::AttachReusePortCpuFilter(int group_size) {
+    return accept_socket_.AttachReusePortCpuFilter(group_size);
+}
+
 void Acceptor::SetNewConnectionCallback(NewConnectionCallback cb) {
     new_connection_callback_ = std::move(cb);
 }
 
+void Acceptor::SetAcceptBatch(int batch) {
+    accept_batch_ = batch > 0 ? batch : 1;
+}
+
+void Acceptor::SetAdmissionCallback(AdmissionCallback cb, OverloadAction action) {
+    admission_callback_ = std::move(cb);
+    overload_action_ = action;
+}
+
+void Acceptor::SetCounters(std::shared_ptr<AcceptorCounters> counters) {
+    counters_ = std::move(counters);
+}
+
 void Acceptor::HandleRead() {
-    // 当有新连接到来时, 调用 Accept 接受连接
-    InetAddress peer_addr;  // NOTE: 默认 port:0 ip:127.0.0.1
-    int connfd = accept_socket_.Accept(&peer_addr);
-    if (connfd >= 0) {
-        // 如果有新连接回调函数则调用
-        // NOTE: 由 TcpServer 通过 Acceptor::SetNewConnectionCallback 设置
-        if (new_connection_callback_) {
-            // NOTE: 将 connfd 和 peer_addr 传递给 TcpServer::NewConnection
-            new_connection_callback_(connfd, peer_addr);
+    // NOTE: 一次可读事件中循环 accept, 直到没有已完成握手的连接(EAGAIN)或达到 accept_batch_
+    // 剩下的连接留给下一轮 epoll_wait(LT 模式下监听 socket 仍然可读)
+    for (int i = 0; i < accept_batch_; ++i) {
+        if (admission_callback_) {
+            if (auto delay = admission_callback_(); delay.count() > 0) {
+                if (overload_action_ == OverloadAction::kPauseAccept) {
+                    PauseAccepting(delay);
+                    return;
+                }
+                if (!RejectConnection()) {
+                    return;
+                }
+                continue;
+            }
         }
-        // 否则关闭连接
-        else {
-            close(connfd);
+        InetAddress peer_addr;  // NOTE: 默认 port:0 ip:127.0.0.1
+        int connfd = accept_socket_.Accept(&peer_addr);
+        if (connfd >= 0) {
+            // 如果有新连接回调函数则调用
+            // NOTE: 由 TcpServer 通过 Acceptor::SetNewConnectionCallback 设置
+            if (new_connection_callback_) {
+                // NOTE: 将 connfd 和 peer_addr 传递给 TcpServer::NewConnection
+                new_connection_callback_(connfd, peer_addr);
+            }
+            // 否则关闭连接
+            else {
+                close(connfd);
+            }
+            // NOTE: Stop 可能在新连接回调中被调用
+            if (!listenning_) {
+                return;
+            }
+            continue;
         }
-    } else {
-        LOG_ERROR("%s:%s:%d accept err:%d\n", __FILE__, __FUNCTION__, __LINE__, errno);
-        if (errno == EMFILE) {
-            LOG_ERROR("%s:%s:%d sockfd reached limit\n", __FILE__, __FUNCTION__, __LINE__);
+        switch (errno) {
+            case EAGAIN:
+                return;  // 已经没有待 accept 的连接
+            case EINTR:
+            case ECONNABORTED:  // 对端在 accept 之前重置了连接
+            case EPROTO:
+                continue;
+            case EMFILE:
+            case ENFILE:
+                if (!ShedConnection()) {
+                    return;
+                }
+                continue;
+            default:
+                LOG_ERROR("%s:%s:%d accept err:%d\n", __FILE__, __FUNCTION__, __LINE__, errno);
+                return;
+        }
+    }
+}
+
+bool Acceptor::ShedConnection() {
+    if (idle_fd_ < 0) {
+        // 上次没能重新预留(fd 被其他线程占用), 再试一次; 仍然失败只能等下一次可读事件
+        idle_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (idle_fd_ < 0) {
+            return false;
         }
     }
+    if (counters_->shed.fetch_add(1, std::memory_order_relaxed) == 0) {
+        LOG_ERROR("%s:%s:%d sockfd reached limit, shedding new connections\n", __FILE__, __FUNCTION__, __LINE__);
+    }
+    close(idle_fd_);
+    int connfd = ::accept(accept_socket_.sockfd(), nullptr, nullptr);
+    if (connfd >= 0) {
+        close(connfd);
+    }
+    idle_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    return true;
+}
+
+bool Acceptor::RejectConnection() {
+    int connfd = ::accept4(accept_socket_.sockfd(), nullptr, nullptr, SOCK_CLOEXEC);
+    if (connfd < 0) {
+        return false;  // EAGAIN 或其他错误: 都留给下一次可读事件
+    }
+    // NOTE: SO_LINGER 为 0 时 close 直接发送 RST, 服务端不进入 TIME_WAIT
+    linger lg{1, 0};
+    setsockopt(connfd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(connfd);
+    if (counters_->rejected.fetch_add(1, std::memory_order_relaxed) == 0) {
+        LOG_ERROR("%s:%s:%d over admission limit, rejecting new connections\n", __FILE__, __FUNCTION__, __LINE__);
+    }
+    return true;
+}
+
+void Acceptor::PauseAccepting(std::chrono::nanoseconds delay) {
+    // NOTE: 至少等 1ms, 避免过于频繁地修改 epoll 注册
+    delay = std::max<std::chrono::nanoseconds>(delay, std::chrono::milliseconds(1));
+    accept_channel_.DisableReading();
+    counters_->paused.fetch_add(1, std::memory_order_relaxed);
+    resume_timer_ = loop_->RunAfter(delay, [this] { ResumeAccepting(); });
+}
+
+void Acceptor::ResumeAccepting() {
+    resume_timer_ = TimerId{};
+    if (listenning_) {
+        accept_channel_.EnableReading();  // 仍然超限时下一次可读事件会再次暂停
+    }
 }
 
 }  // namespace cutemuduo
@@ -0,0 +1,71 @@
+#include <cutemuduo/block_pool.hpp>
+
+namespace cutemuduo {
+
+namespace block_pool {
+
+namespace {
+
+constexpr size_t kBlockSizeClass = 64;                                     // 分级粒度
+constexpr size_t kNumSizeClasses = kMaxPooledBlockSize / kBlockSizeClass;  // 级数
+constexpr size_t kMaxFreeBlocksPerClass = 256;                             // 每级最多缓存的空闲块
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct Pool {
+    FreeBlock* free_lists[kNumSizeClasses] = {};
+    size_t free_counts[kNumSizeClasses] = {};
+
+    ~Pool();
+};
+
+thread_local Pool pool;
+thread_local bool pool_destroyed = false;  // 线程退出时内存池已析构, 之后的释放直接还给系统
+
+Pool::~Pool() {
+    for (auto& head : free_lists) {
+        while (head) {
+            FreeBlock* next = head->next;
+            ::operator delete(head);
+            head = next;
+        }
+    }
+    pool_destroyed = true;
+}
+
+}  // namespace
+
+void* Allocate(size_t size) {
+    if (size == 0 || size > kMaxPooledBlockSize || pool_destroyed) {
+        return ::operator new(size);
+    }
+    size_t index = (size - 1) / kBlockSizeClass;
+    if (FreeBlock* block = pool.free_lists[index]) {
+        pool.free_lists[index] = block->next;
+        --pool.free_counts[index];
+        return block;
+    }
+    return ::operator new((index + 1) * kBlockSizeClass);
+}
+
+void Deallocate(void* ptr, size_t size) {
+    if (size == 0 || size > kMaxPooledBlockSize || pool_destroyed) {
+        ::operator delete(ptr);
+        return;
+    }
+    size_t index = (size - 1) / kBlockSizeClass;
+    if (pool.free_counts[index] >= kMaxFreeBlocksPerClass) {
+        ::operator delete(ptr);
+        return;
+    }
+    auto block = static_cast<FreeBlock*>(ptr);
+    block->next = pool.free_lists[index];
+    pool.free_lists[index] = block;
+    ++pool.free_counts[index];
+}
+
+}  // namespace block_pool
+
+}  // namespace cutemuduo
@@ -1,10 +1,21 @@
+#include <poll.h>
+//
 #include <cutemuduo/channel.hpp>
 #include <cutemuduo/event_loop.hpp>
 #include <cutemuduo/logger.hpp>
 
 namespace cutemuduo {
 
-Channel::Channel(EventLoop* loop, int fd) : loop_(loop), fd_(fd), events_(0), revents_(0), index_(-1), tied_(false) {}
+Channel::Channel(EventLoop* loop, int fd)
+    : loop_(loop),
+      fd_(fd),
+      events_(0),
+      revents_(0),
+      index_(-1),
+      handler_(nullptr),
+      tied_(false),
+      owner_name_func_(nullptr),
+      owner_(nullptr) {}
 
 Channel::~Channel() {}
 
@@ -20,6 +31,13 @@ void Channel::SetCloseCallback(EventCallback cb) {
 void Channel::SetErrorCallback(EventCallback cb) {
     error_callback_ = std::move(cb);
 }
+void Channel::SetHandler(ChannelHandler* handler) {
+    handler_ = handler;
+}
+void Channel::SetOwnerName(OwnerNameFunc func, void const* owner) {
+    owner_name_func_ = func;
+    owner_ = owner;
+}
 
 //               Channel Update/Remove
 //                        ↓
@@ -78,25 +96,46 @@ void Channel::SetRevents(int revents) {
 }
 
 void Channel::HandleEvent(Timestamp receive_time) {
+    // NOTE: guard 必须覆盖整个回调过程, 否则回调执行期间所属对象(及本 Channel)可能被析构
+    // 设置了 Handler 的 Channel 不 Tie, 由所有者保证回调期间不析构(见 ChannelHandler)
+    std::shared_ptr<void> guard;
     if (tied_) {
-        std::shared_ptr<void> guard = tie_.lock();
+        guard = tie_.lock();
         if (!guard) {
             return;  // 提升失败，不做任何处理
         }
     }
+    WatchdogSlot* watchdog = loop_->watchdog();
+    if (!watchdog) {
+        HandleEventWithGuard(receive_time);
+        return;
+    }
+    int fd = fd_;                    // NOTE: 未 Tie 的 Channel 可能在回调中被销毁, 之后不能再访问成员
+    bool owned = guard || handler_;  // 回调之后所属对象(及本 Channel)仍然存在
+    watchdog->Begin(CallbackPhase::kChannel, fd);
     HandleEventWithGuard(receive_time);
+    if (int64_t elapsed_ns = watchdog->End()) {
+        char const* owner = owned && owner_name_func_ ? owner_name_func_(owner_).c_str() : "-";
+        LOG_WARNING("Channel fd=%d owner=%s slow callback finished after %ld ms\n", fd, owner,
+                    static_cast<long>(elapsed_ns / 1000000));
+    }
 }
 
 void Channel::HandleEventWithGuard(Timestamp receiveTime) {
-    LOG_INFO("channel HandleEvent revents: %d\n", revents_);
+    // NOTE: 每个事件都会走到这里, 用 DEBUG 级别避免日志成为热点
+    LOG_DEBUG("channel HandleEvent revents: %d\n", revents_);
+    if (handler_) {
+        HandleEventWithHandler(receiveTime);
+        return;
+    }
     // 关闭, 当TcpConnection对应Channel 通过shutdown 关闭写端 epoll触发EPOLLHUP
     if ((revents_ & EPOLLHUP) && !(revents_ & EPOLLIN)) {
         if (close_callback_) {
             close_callback_();
         }
     }
-    // 错误
-    if (revents_ & EPOLLERR) {
+    // 错误(POLLNVAL: 使用 PollPoller 时 fd 无效)
+    if (revents_ & (EPOLLERR | POLLNVAL)) {
         if (error_callback_) {
             error_callback_();
         }
@@ -115,6 +154,22 @@ void Channel::HandleEventWithGuard(Timestamp receiveTime) {
     }
 }
 
+void Channel::HandleEventWithHandler(Timestamp receive_time) {
+    // NOTE: 与上面的判断顺序一致
+    if ((revents_ & EPOLLHUP) && !(revents_ & EPOLLIN)) {
+        handler_->HandleClose();
+    }
+    if (revents_ & (EPOLLERR | POLLNVAL)) {
+        handler_->HandleError();
+    }
+    if (revents_ & (EPOLLIN | EPOLLPRI)) {
+        handler_->HandleRead(receive_time);
+    }
+    if (revents_ & EPOLLOUT) {
+        handler_->HandleWrite();
+    }
+}
+
 int Channel::fd() const {
     return fd_;
 }
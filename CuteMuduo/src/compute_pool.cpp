@@ -0,0 +1,220 @@
+#include <random>
+//
+#include <cutemuduo/compute_pool.hpp>
+#include <cutemuduo/logger.hpp>
+
+namespace cutemuduo {
+
+namespace {
+
+// 工作线程本地攒的完成回调(按 EventLoop 分组)
+struct CompletionBatch {
+    struct Entry {
+        EventLoop* loop;
+        std::vector<EventLoop::Functor> functors;
+    };
+
+    std::vector<Entry> entries;
+    size_t size = 0;
+
+    void Add(EventLoop* loop, EventLoop::Functor then) {
+        for (auto& entry : entries) {
+            if (entry.loop == loop) {
+                entry.functors.push_back(std::move(then));
+                ++size;
+                return;
+            }
+        }
+        entries.push_back({loop, {}});
+        entries.back().functors.push_back(std::move(then));
+        ++size;
+    }
+
+    // 每个 loop 只投递一个任务, 在 loop 线程中依次执行这一批回调
+    void Flush() {
+        for (auto& entry : entries) {
+            entry.loop->QueueInLoop([functors = std::move(entry.functors)]() mutable {
+                for (auto& functor : functors) {
+                    functor();
+                }
+            });
+        }
+        entries.clear();
+        size = 0;
+    }
+};
+
+// 当前线程所属的 ComputePool 工作线程信息(非工作线程为空)
+thread_local CompletionBatch* completion_batch = nullptr;
+thread_local ComputePool* current_pool = nullptr;
+thread_local int current_worker = -1;
+
+}  // namespace
+
+ComputePool::ComputePool(int num_workers, std::string const& name)
+    : name_(name), running_(false), stopped_(false), next_worker_(0), pending_(0), idle_workers_(0), steals_(0) {
+    if (num_workers <= 0) {
+        num_workers = 1;
+    }
+    for (int i = 0; i < num_workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+}
+
+ComputePool::~ComputePool() {
+    Stop();
+}
+
+void ComputePool::Start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    stopped_ = false;
+    for (int i = 0; i < num_workers(); ++i) {
+        char buf[64] = {0};
+        snprintf(buf, sizeof(buf), "%s%d", name_.c_str(), i);
+        threads_.push_back(std::make_unique<Thread>([this, i] { WorkerLoop(i); }, buf));
+        threads_.back()->Start();
+    }
+}
+
+void ComputePool::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::unique_lock lk{sleep_mtx_};
+        sleep_cv_.notify_all();
+    }
+    for (auto& thread : threads_) {
+        thread->Join();
+    }
+    threads_.clear();
+    // NOTE: 工作线程退出前可能还有 Submit 放进队列的任务: 在这里执行;
+    // stopped_ 在各队列的锁内检查, 之后的 Submit 都看得到它, 不会再放进队列
+    stopped_ = true;
+    for (auto& worker : workers_) {
+        std::deque<Task> tasks;
+        {
+            std::unique_lock lk{worker->mtx};
+            tasks.swap(worker->tasks);
+        }
+        for (auto& task : tasks) {
+            pending_.fetch_sub(1);
+            task();
+        }
+    }
+}
+
+bool ComputePool::Submit(Task task) {
+    size_t index;
+    if (current_pool == this) {
+        index = static_cast<size_t>(current_worker);  // 工作线程中提交: 放进自己的队列
+    } else {
+        index = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    }
+    {
+        std::unique_lock lk{workers_[index]->mtx};
+        if (!stopped_) {
+            workers_[index]->tasks.push_back(std::move(task));
+            pending_.fetch_add(1);
+            lk.unlock();
+            NotifyOne();
+            return true;
+        }
+    }
+    LOG_WARNING("ComputePool::Submit [%s] - pool is stopped, task rejected\n", name_.c_str());
+    return false;
+}
+
+void ComputePool::PostCompletion(EventLoop* loop, EventLoop::Functor then) {
+    if (!completion_batch) {
+        loop->RunInLoop(std::move(then));
+        return;
+    }
+    completion_batch->Add(loop, std::move(then));
+    if (completion_batch->size >= kMaxCompletionBatch) {
+        completion_batch->Flush();
+    }
+}
+
+void ComputePool::NotifyOne() {
+    // NOTE: 与 WorkerLoop 中的 idle_workers_++ / pending_ 检查构成 Dekker 式同步(均为 seq_cst):
+    // 要么这里看到有线程空闲并唤醒它, 要么准备睡眠的线程看到 pending_ > 0 而不睡
+    if (idle_workers_.load() > 0) {
+        std::unique_lock lk{sleep_mtx_};
+        sleep_cv_.notify_one();
+    }
+}
+
+bool ComputePool::PopLocal(int index, Task& task) {
+    Worker& worker = *workers_[index];
+    std::unique_lock lk{worker.mtx};
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool ComputePool::Steal(int thief, Task& task) {
+    static thread_local std::minstd_rand rng{std::random_device{}()};
+    int n = num_workers();
+    int start = static_cast<int>(rng() % n);
+    for (int i = 0; i < n; ++i) {
+        int victim = (start + i) % n;
+        if (victim == thief) {
+            continue;
+        }
+        Worker& worker = *workers_[victim];
+        std::unique_lock lk{worker.mtx};
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ComputePool::WorkerLoop(int index) {
+    CompletionBatch batch;
+    completion_batch = &batch;
+    current_pool = this;
+    current_worker = index;
+
+    Task task;
+    while (true) {
+        if (PopLocal(index, task)) {
+            pending_.fetch_sub(1);
+            task();
+            task.Reset();
+            continue;
+        }
+        // 自己的队列空了: 先把攒着的完成回调投递出去, 再去偷取或睡眠
+        // NOTE: 偷来的任务可能要执行很久, 不能让已经完成的回调一直等着
+        batch.Flush();
+        if (Steal(index, task)) {
+            pending_.fetch_sub(1);
+            task();
+            task.Reset();
+            continue;
+        }
+        std::unique_lock lk{sleep_mtx_};
+        idle_workers_.fetch_add(1);
+        sleep_cv_.wait(lk, [this] { return pending_.load() > 0 || !running_; });
+        idle_workers_.fetch_sub(1);
+        if (!running_ && pending_.load() == 0) {
+            break;
+        }
+    }
+
+    batch.Flush();
+    completion_batch = nullptr;
+    current_pool = nullptr;
+    current_worker = -1;
+}
+
+}  // namespace cutemuduo
@@ -0,0 +1,212 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <random>
+//
+#include <cutemuduo/channel.hpp>
+#include <cutemuduo/connector.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/logger.hpp>
+
+namespace cutemuduo {
+
+static int SocketError(int sockfd) {
+    int optval = 0;
+    socklen_t optlen = sizeof(optval);
+    if (getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0) {
+        return errno;
+    }
+    return optval;
+}
+
+// 自连接: 连接本机上没有监听的端口时, 内核选的临时端口可能恰好等于目标端口, 同时打开后连到了自己
+static bool IsSelfConnect(int sockfd) {
+    sockaddr_storage local{};
+    sockaddr_storage peer{};
+    socklen_t local_len = sizeof(local);
+    socklen_t peer_len = sizeof(peer);
+    if (getsockname(sockfd, reinterpret_cast<sockaddr*>(&local), &local_len) < 0 ||
+        getpeername(sockfd, reinterpret_cast<sockaddr*>(&peer), &peer_len) < 0) {
+        return false;
+    }
+    if (local.ss_family == AF_UNIX) {
+        return false;
+    }
+    return InetAddress(reinterpret_cast<sockaddr*>(&local), local_len).ToIpPort() ==
+           InetAddress(reinterpret_cast<sockaddr*>(&peer), peer_len).ToIpPort();
+}
+
+Connector::Connector(EventLoop* loop, InetAddress const& server_addr)
+    : loop_(loop),
+      server_addr_(server_addr),
+      connect_(false),
+      state_(State::kDisconnected),
+      initial_retry_delay_(kInitialRetryDelay),
+      max_retry_delay_(kMaxRetryDelay),
+      retry_delay_(kInitialRetryDelay) {}
+
+Connector::~Connector() {
+    if (channel_) {
+        LOG_ERROR("Connector::dtor - still connecting to %s\n", server_addr_.ToIpPort().c_str());
+    }
+}
+
+void Connector::SetRetryDelay(std::chrono::milliseconds initial, std::chrono::milliseconds max) {
+    initial_retry_delay_ = std::max(initial, std::chrono::milliseconds{1});
+    max_retry_delay_ = std::max(max, initial_retry_delay_);
+    retry_delay_ = initial_retry_delay_;
+}
+
+void Connector::Start() {
+    connect_ = true;
+    loop_->RunInLoop([self = shared_from_this()] { self->StartInLoop(); }, EventLoop::Priority::kControl);
+}
+
+void Connector::StartInLoop() {
+    if (connect_ && state_ == State::kDisconnected && retry_timer_.seq == 0) {
+        Connect();
+    }
+}
+
+void Connector::Disconnected() {
+    if (state_ == State::kConnected) {
+        state_ = State::kDisconnected;
+    }
+}
+
+void Connector::Restart() {
+    connect_ = true;
+    // NOTE: 连接建立后很快又断开时立即重连会变成没有退避的连接风暴, 只有连接稳定过才重置重试间隔
+    if (std::chrono::steady_clock::now() - connected_at_ >= kStableConnectionTime) {
+        retry_delay_ = initial_retry_delay_;
+        StartInLoop();
+    } else {
+        Retry(-1);
+    }
+}
+
+void Connector::Stop() {
+    connect_ = false;
+    loop_->RunInLoop([self = shared_from_this()] { self->StopInLoop(); }, EventLoop::Priority::kControl);
+}
+
+void Connector::StopInLoop() {
+    loop_->CancelTimer(retry_timer_);
+    retry_timer_ = TimerId{};
+    if (state_ == State::kConnecting) {
+        state_ = State::kDisconnected;
+        close(RemoveAndResetChannel());
+    }
+}
+
+void Connector::Connect() {
+    int sockfd = socket(server_addr_.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sockfd < 0) {
+        LOG_ERROR("Connector::Connect - socket err:%d\n", errno);
+        Retry(-1);
+        return;
+    }
+    int ret = connect(sockfd, server_addr_.GetSockAddr(), server_addr_.length());
+    int saved_errno = ret == 0 ? 0 : errno;
+    switch (saved_errno) {
+        case 0:
+        case EINPROGRESS:
+        case EINTR:
+        case EISCONN:
+            Connecting(sockfd);
+            break;
+
+        // 服务端暂时不可用: 退避后重试
+        case EAGAIN:
+        case EADDRINUSE:
+        case EADDRNOTAVAIL:
+        case ECONNREFUSED:
+        case ENETUNREACH:
+        case ENOENT:  // Unix 域 socket 文件还不存在
+            Retry(sockfd);
+            break;
+
+        // 地址/参数错误: 重试也不会成功
+        default:
+            LOG_ERROR("Connector::Connect - connect to %s err:%d, giving up\n", server_addr_.ToIpPort().c_str(),
+                      saved_errno);
+            close(sockfd);
+            break;
+    }
+}
+
+void Connector::Connecting(int sockfd) {
+    state_ = State::kConnecting;
+    channel_ = std::make_unique<Channel>(loop_, sockfd);
+    // NOTE: 回调捕获 this: Channel 由本对象持有, 销毁前先从 Poller 中移除
+    channel_->SetWriteCallback([this] { HandleWrite(); });
+    channel_->SetErrorCallback([this] { HandleError(); });
+    channel_->EnableWriting();  // 非阻塞 connect 完成(成功或失败)时 socket 可写
+}
+
+void Connector::HandleWrite() {
+    if (state_ != State::kConnecting) {
+        return;
+    }
+    int sockfd = RemoveAndResetChannel();
+    int err = SocketError(sockfd);
+    if (err != 0) {
+        LOG_WARNING("Connector::HandleWrite - connect to %s err:%d\n", server_addr_.ToIpPort().c_str(), err);
+        Retry(sockfd);
+    } else if (IsSelfConnect(sockfd)) {
+        LOG_WARNING("Connector::HandleWrite - self connect to %s\n", server_addr_.ToIpPort().c_str());
+        Retry(sockfd);
+    } else if (!connect_) {
+        close(sockfd);
+        state_ = State::kDisconnected;
+    } else {
+        state_ = State::kConnected;
+        connected_at_ = std::chrono::steady_clock::now();  // NOTE: 退避等连接断开时再决定是否重置(见 Restart)
+        new_connection_callback_(sockfd);
+    }
+}
+
+void Connector::HandleError() {
+    if (state_ != State::kConnecting) {
+        return;
+    }
+    int sockfd = RemoveAndResetChannel();
+    LOG_WARNING("Connector::HandleError - connect to %s err:%d\n", server_addr_.ToIpPort().c_str(),
+                SocketError(sockfd));
+    Retry(sockfd);
+}
+
+void Connector::Retry(int sockfd) {
+    if (sockfd >= 0) {
+        close(sockfd);
+    }
+    state_ = State::kDisconnected;
+    if (!connect_) {
+        return;
+    }
+    // NOTE: 等待时间在 [retry_delay_/2, retry_delay_] 内随机
+    static thread_local std::minstd_rand rng{std::random_device{}()};
+    auto half = retry_delay_ / 2;
+    auto delay = half + std::chrono::milliseconds(rng() % (half.count() + 1));
+    LOG_INFO("Connector::Retry - connect to %s again in %ld ms\n", server_addr_.ToIpPort().c_str(),
+             static_cast<long>(delay.count()));
+    retry_timer_ = loop_->RunAfter(delay, [weak = weak_from_this()] {
+        if (auto self = weak.lock()) {
+            self->retry_timer_ = TimerId{};
+            self->StartInLoop();
+        }
+    });
+    retry_delay_ = std::min(retry_delay_ * 2, max_retry_delay_);
+}
+
+int Connector::RemoveAndResetChannel() {
+    int sockfd = channel_->fd();
+    channel_->DisableAll();
+    channel_->Remove();
+    loop_->QueueInLoop([channel = std::move(channel_)] {}, EventLoop::Priority::kControl);
+    return sockfd;
+}
+
+}  // namespace cutemuduo
@@ -0,0 +1,127 @@
+#include <algorithm>
+//
+#include <cutemuduo/coroutine.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/logger.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+
+namespace cutemuduo {
+
+// =================== Spawn ===================
+
+namespace {
+
+// 不被任何人等待的顶层协程: 立即开始执行, 结束后自动销毁
+struct DetachedTask {
+    struct promise_type : PooledPromise {
+        DetachedTask get_return_object() noexcept { return {}; }
+
+        std::suspend_never initial_suspend() noexcept { return {}; }
+
+        std::suspend_never final_suspend() noexcept { return {}; }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept {
+            try {
+                throw;
+            } catch (std::exception const& e) {
+                LOG_ERROR("coroutine exited with exception: %s\n", e.what());
+            } catch (...) {
+                LOG_ERROR("coroutine exited with unknown exception\n");
+            }
+        }
+    };
+};
+
+DetachedTask RunDetached(Task<void> task) {
+    co_await std::move(task);
+}
+
+}  // namespace
+
+void Spawn(Task<void> task) {
+    RunDetached(std::move(task));
+}
+
+void Spawn(EventLoop* loop, Task<void> task) {
+    loop->RunInLoop([task = std::move(task)]() mutable { Spawn(std::move(task)); });
+}
+
+// =================== EventLoop ===================
+
+SleepAwaiter EventLoop::Sleep(std::chrono::nanoseconds delay) {
+    return SleepAwaiter(this, delay);
+}
+
+SwitchToAwaiter EventLoop::SwitchTo(EventLoop* other) {
+    return SwitchToAwaiter(other);
+}
+
+void SleepAwaiter::await_suspend(std::coroutine_handle<> h) {
+    loop_->RunAfter(delay_, [h] { h.resume(); });
+}
+
+bool SwitchToAwaiter::await_ready() const {
+    return target_->IsInLoopThread();
+}
+
+void SwitchToAwaiter::await_suspend(std::coroutine_handle<> h) {
+    target_->QueueInLoop([h] { h.resume(); });
+}
+
+// =================== TcpConnection ===================
+
+bool ReadAwaiter::Ready() {
+    Buffer& buffer = conn_->input_buffer_;
+    size_t readable = buffer.ReadableBytes();
+    if (delim_.empty()) {
+        return readable >= want_;
+    }
+    if (readable < delim_.size()) {
+        return false;
+    }
+    // 从上次查找的末尾(回退 delim 长度 - 1, 防止分隔符跨越两次读取)继续查找
+    size_t start = scanned_ >= delim_.size() ? scanned_ - (delim_.size() - 1) : 0;
+    char const* begin = buffer.Peek();
+    char const* end = begin + readable;
+    char const* pos = std::search(begin + start, end, delim_.begin(), delim_.end());
+    if (pos != end) {
+        found_ = static_cast<size_t>(pos - begin) + delim_.size();
+        return true;
+    }
+    scanned_ = readable;
+    return false;
+}
+
+bool ReadAwaiter::await_ready() {
+    return Ready() || conn_->state_ == TcpConnection::StateE::kDisconnected;
+}
+
+void ReadAwaiter::await_suspend(std::coroutine_handle<> h) {
+    handle_ = h;
+    conn_->read_waiter_ = this;
+}
+
+std::string ReadAwaiter::await_resume() {
+    Buffer& buffer = conn_->input_buffer_;
+    if (!Ready()) {
+        return buffer.RetrieveAllAsString();  // 对端已关闭
+    }
+    return buffer.RetrieveAsString(delim_.empty() ? want_ : found_);
+}
+
+bool WriteAwaiter::await_ready() {
+    return conn_->output_buffer_.ReadableBytes() == 0 || conn_->state_ == TcpConnection::StateE::kDisconnected;
+}
+
+void WriteAwaiter::await_suspend(std::coroutine_handle<> h) {
+    handle_ = h;
+    conn_->write_waiter_ = this;
+}
+
+bool WriteAwaiter::await_resume() {
+    return conn_->state_ != TcpConnection::StateE::kDisconnected && conn_->output_buffer_.ReadableBytes() == 0;
+}
+
+}  // namespace cutemuduo
@@ -0,0 +1,164 @@
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+//
+#include <cutemuduo/cpu_affinity.hpp>
+#include <cutemuduo/logger.hpp>
+
+namespace cutemuduo {
+
+std::vector<int> CpuAffinity::Assign(int num_threads) const {
+    std::vector<int> result(num_threads > 0 ? num_threads : 0, -1);
+    std::vector<int> candidates;
+    if (mode == Mode::kCpuList) {
+        candidates = cpus;
+    } else if (mode == Mode::kOnePerPhysicalCore) {
+        candidates = cpu_affinity::PhysicalCoreCpus();
+    }
+    if (candidates.empty()) {
+        return result;
+    }
+    for (size_t i = 0; i < result.size(); ++i) {
+        result[i] = candidates[i % candidates.size()];
+    }
+    return result;
+}
+
+namespace cpu_affinity {
+
+// 解析 "0-3,8,10-11" 形式的 CPU 列表
+static std::set<int> ParseCpuList(std::string const& list) {
+    std::set<int> cpus;
+    char const* p = list.c_str();
+    while (*p) {
+        char* end = nullptr;
+        long lo = strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        long hi = lo;
+        p = end;
+        if (*p == '-') {
+            hi = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long cpu = lo; cpu <= hi; ++cpu) {
+            cpus.insert(static_cast<int>(cpu));
+        }
+        if (*p == ',') {
+            ++p;
+        } else {
+            break;
+        }
+    }
+    return cpus;
+}
+
+static std::string ReadFirstLine(std::string const& path) {
+    FILE* fp = fopen(path.c_str(), "r");
+    if (!fp) {
+        return {};
+    }
+    char buf[256] = {0};
+    if (!fgets(buf, sizeof(buf), fp)) {
+        buf[0] = '\0';
+    }
+    fclose(fp);
+    return buf;
+}
+
+// 当前线程允许运行的 CPU(受 taskset / cgroup cpuset 限制)
+static std::vector<int> AllowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+
+std::vector<int> PhysicalCoreCpus() {
+    std::vector<int> allowed = AllowedCpus();
+    std::set<int> allowed_set(allowed.begin(), allowed.end());
+    std::vector<std::pair<int, int>> cores;  // (NUMA 节点, CPU)
+    for (int cpu : allowed) {
+        std::string siblings =
+            ReadFirstLine("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+        std::set<int> sibling_set = ParseCpuList(siblings);
+        // NOTE: 同一物理核的超线程中只保留允许运行的、编号最小的那个
+        bool first = true;
+        for (int sibling : sibling_set) {
+            if (sibling < cpu && allowed_set.count(sibling)) {
+                first = false;
+                break;
+            }
+        }
+        if (first) {
+            cores.emplace_back(NumaNodeOfCpu(cpu), cpu);
+        }
+    }
+    std::sort(cores.begin(), cores.end());
+    std::vector<int> result;
+    for (auto const& core : cores) {
+        result.push_back(core.second);
+    }
+    return result;
+}
+
+int NumaNodeOfCpu(int cpu) {
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return 0;
+    }
+    int node = 0;
+    while (struct dirent* entry = readdir(dir)) {
+        // 目录下的 nodeN 符号链接指向所在的 NUMA 节点
+        if (sscanf(entry->d_name, "node%d", &node) == 1) {
+            break;
+        }
+        node = 0;
+    }
+    closedir(dir);
+    return node;
+}
+
+bool PinCurrentThread(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        LOG_ERROR("pthread_setaffinity_np cpu=%d error:%d\n", cpu, err);
+        return false;
+    }
+    // NOTE: 默认策略通常已经是本地分配, 但进程可能被 numactl --interleave 等启动, 这里显式设为本地节点优先
+    // 不依赖 libnuma, 内核不支持(ENOSYS)时忽略
+    if (syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0) != 0 && errno != ENOSYS) {
+        LOG_WARNING("set_mempolicy(MPOL_LOCAL) error:%d\n", errno);
+    }
+    LOG_INFO("thread pinned to cpu %d (numa node %d)\n", cpu, NumaNodeOfCpu(cpu));
+    return true;
+}
+
+}  // namespace cpu_affinity
+
+}  // namespace cutemuduo
@@ -1,9 +1,16 @@
+#include <stdlib.h>
+//
 #include <cutemuduo/epoll_poller.hpp>
+#include <cutemuduo/poll_poller.hpp>
 
 namespace cutemuduo {
 
 // cpp hpp ODR
 Poller* Poller::NewDefaultPoller(EventLoop* loop) {
+    // NOTE: 与 muduo 的 MUDUO_USE_POLL 相同, 设置了环境变量 CUTEMUDUO_USE_POLL 则使用 poll
+    if (::getenv("CUTEMUDUO_USE_POLL")) {
+        return new PollPoller(loop);
+    }
     return new EpollPoller(loop);
 }
 }  // namespace cutemuduo
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <string>
+//
+#include <cutemuduo/dispatch_policy.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/inet_address.hpp>
+
+namespace cutemuduo {
+
+namespace {
+
+// FNV-1a + murmur3 finalizer: 跨进程稳定(重启后同一客户端仍落在同一个 loop 上), 分布均匀
+uint64_t Hash(std::string const& s) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+class RoundRobinPolicy : public DispatchPolicy {
+public:
+    size_t Select(std::vector<EventLoop*> const& loops, InetAddress const&) override {
+        size_t index = next_ % loops.size();
+        next_ = index + 1;
+        return index;
+    }
+
+private:
+    size_t next_ = 0;
+};
+
+class LeastConnectionsPolicy : public DispatchPolicy {
+public:
+    size_t Select(std::vector<EventLoop*> const& loops, InetAddress const&) override {
+        size_t n = loops.size();
+        size_t start = next_++ % n;  // NOTE: 从轮转的起点开始找, 连接数相同时相当于轮询
+        size_t best = start;
+        size_t best_connections = loops[start]->connections();
+        for (size_t i = 1; i < n && best_connections > 0; ++i) {
+            size_t index = (start + i) % n;
+            size_t connections = loops[index]->connections();
+            if (connections < best_connections) {
+                best = index;
+                best_connections = connections;
+            }
+        }
+        return best;
+    }
+
+private:
+    size_t next_ = 0;
+};
+
+class LeastLatencyPolicy : public DispatchPolicy {
+public:
+    size_t Select(std::vector<EventLoop*> const& loops, InetAddress const&) override {
+        size_t n = loops.size();
+        size_t start = next_++ % n;
+        size_t best = start;
+        uint64_t best_latency = loops[start]->recent_latency_ns();
+        size_t best_connections = loops[start]->connections();
+        for (size_t i = 1; i < n; ++i) {
+            size_t index = (start + i) % n;
+            uint64_t latency = loops[index]->recent_latency_ns();
+            size_t connections = loops[index]->connections();
+            if (latency < best_latency || (latency == best_latency && connections < best_connections)) {
+                best = index;
+                best_latency = latency;
+                best_connections = connections;
+            }
+        }
+        return best;
+    }
+
+private:
+    size_t next_ = 0;
+};
+
+class ConsistentHashPolicy : public DispatchPolicy {
+public:
+    explicit ConsistentHashPolicy(int virtual_nodes) : virtual_nodes_(std::max(virtual_nodes, 1)) {}
+
+    void Init(std::vector<EventLoop*> const& loops) override {
+        ring_.clear();
+        ring_.reserve(loops.size() * virtual_nodes_);
+        for (size_t i = 0; i < loops.size(); ++i) {
+            for (int v = 0; v < virtual_nodes_; ++v) {
+                ring_.emplace_back(Hash("loop" + std::to_string(i) + "#" + std::to_string(v)), i);
+            }
+        }
+        std::sort(ring_.begin(), ring_.end());
+    }
+
+    size_t Select(std::vector<EventLoop*> const& loops, InetAddress const& peer) override {
+        if (ring_.empty()) {
+            Init(loops);
+        }
+        std::string ip = peer.ToIp();
+        if (ip.empty()) {
+            // NOTE: 没有名字的对端(Unix 域 socket 的客户端通常不 bind)无法区分, 哈希会全部落到同一个 loop, 改为轮询
+            size_t index = next_ % loops.size();
+            next_ = index + 1;
+            return index;
+        }
+        // 顺时针找到第一个不小于 hash 的虚拟节点(超过末尾则回到开头)
+        auto it = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(Hash(ip), size_t{0}));
+        if (it == ring_.end()) {
+            it = ring_.begin();
+        }
+        return it->second;
+    }
+
+private:
+    int virtual_nodes_;
+    std::vector<std::pair<uint64_t, size_t>> ring_;  // (虚拟节点哈希, loop 下标), 按哈希排序
+    size_t next_ = 0;                                // 没有名字的对端轮询
+};
+
+}  // namespace
+
+std::unique_ptr<DispatchPolicy> DispatchPolicy::RoundRobin() {
+    return std::make_unique<RoundRobinPolicy>();
+}
+
+std::unique_ptr<DispatchPolicy> DispatchPolicy::LeastConnections() {
+    return std::make_unique<LeastConnectionsPolicy>();
+}
+
+std::unique_ptr<DispatchPolicy> DispatchPolicy::LeastLatency() {
+    return std::make_unique<LeastLatencyPolicy>();
+}
+
+std::unique_ptr<DispatchPolicy> DispatchPolicy::ConsistentHash(int virtual_nodes) {
+    return std::make_unique<ConsistentHashPolicy>(virtual_nodes);
+}
+
+}  // namespace cutemuduo
@@ -1,5 +1,9 @@
 #include <sys/eventfd.h>
+
+#include <algorithm>
+#include <limits>
 //
+#include <cutemuduo/compute_pool.hpp>
 #include <cutemuduo/event_loop.hpp>
 #include <cutemuduo/logger.hpp>
 #include <cutemuduo/poller.hpp>
@@ -12,6 +16,12 @@ thread_local EventLoop* loop_in_this_thread = nullptr;
 // 定义默认的Poller IO复用接口的超时时间
 constexpr int kPollTimeMs{10000};  // 10000 毫秒 = 10 秒钟
 
+// 单调时钟(纳秒), 用于统计各阶段耗时
+static int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
 // 创建 wakeup_fd_
 int CreateEventfd() {
     int evtfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
@@ -25,10 +35,23 @@ EventLoop::EventLoop()
     : looping_(false),
       quit_(false),
       poller_(Poller::NewDefaultPoller(this)),
+      event_handling_(false),
       thread_id_(current_thread::Tid()),
       wakeup_fd_(CreateEventfd()),
       wakeup_channel_(std::make_unique<Channel>(this, wakeup_fd_)),
-      calling_pending_functors_(false) {
+      timer_queue_(std::make_unique<TimerQueue>(this)),
+      wakeup_pending_(false),
+      wakeups_(0),
+      suppressed_wakeups_(0),
+      calling_pending_functors_(false),
+      io_budget_(0),
+      io_cursor_(0),
+      functor_budget_(0),
+      functor_time_budget_(0),
+      has_leftover_(false),
+      connections_(0),
+      compute_pool_(nullptr),
+      watchdog_(nullptr) {
     if (loop_in_this_thread) {
         LOG_FATAL("Another EventLoop %p exists in this thread %d\n", loop_in_this_thread, thread_id_);
     } else {
@@ -45,6 +68,9 @@ EventLoop::~EventLoop() {
     wakeup_channel_->DisableAll();
     wakeup_channel_->Remove();
     close(wakeup_fd_);
+    if (watchdog_slot_) {
+        watchdog_slot_->attached.store(false, std::memory_order_release);  // 通知看门狗丢弃槽位
+    }
     loop_in_this_thread = nullptr;
 }
 
@@ -53,19 +79,62 @@ void EventLoop::Loop() {
     quit_ = false;
 
     LOG_INFO("EventLoop %p start looping\n", this);
+    int64_t phase_start = NowNs();
     while (!quit_) {
         active_channels_.clear();
         //          EventLoop
         //       ↙↗          ↘↖
         //    Poller        Channel
-        poll_return_time_ = poller_->Poll(kPollTimeMs, &active_channels_);
-        for (auto& channel : active_channels_) {
-            channel->HandleEvent(poll_return_time_);  // 依次处理 channel 上的事件
-        }
+        // NOTE: 上一轮还有剩余任务时不阻塞, 处理完就绪的 IO 后继续执行剩余任务
+        counters_.polling_since_ns.store(phase_start, std::memory_order_relaxed);
+        poll_return_time_ = poller_->Poll(has_leftover_ ? 0 : kPollTimeMs, &active_channels_);
+        counters_.polling_since_ns.store(0, std::memory_order_relaxed);
+        has_leftover_ = false;
+        int64_t poll_end = NowNs();
+        HandleActiveChannels();  // 依次处理 channel 上的事件
+        int64_t io_end = NowNs();
         DoPendingFunctors();  // TODO: mainloop -> subloop?
+        int64_t functor_end = NowNs();
+
+        // 各阶段耗时(上一轮的结束时间即本轮 Poll 的开始时间, 每轮只读 3 次时钟)
+        uint64_t num_events = active_channels_.size();
+        EventLoopCounters::Add(counters_.iterations, 1);
+        EventLoopCounters::Add(counters_.poll_events, num_events);
+        EventLoopCounters::Max(counters_.max_poll_events, num_events);
+        EventLoopCounters::Add(counters_.poll_ns, poll_end - phase_start);
+        EventLoopCounters::Add(counters_.io_ns, io_end - poll_end);
+        EventLoopCounters::Add(counters_.functor_ns, functor_end - io_end);
+        EventLoopCounters::Ewma(counters_.recent_busy_ns, functor_end - poll_end);
+        phase_start = functor_end;
     }
     looping_ = false;
-    LOG_INFO("EventLoop %p stop looping\n", this);
+    LOG_INFO("EventLoop %p stop looping (%s)\n", this, GetStats().ToString().c_str());
+}
+
+void EventLoop::HandleActiveChannels() {
+    // NOTE: 回调中可能析构同一批中的其他 Channel(例如在定时器回调中析构 TcpServer, 其 Acceptor 也就绪了),
+    // RemoveChannel 把它们置空
+    event_handling_ = true;
+    size_t n = active_channels_.size();
+    if (io_budget_ == 0 || n <= io_budget_) {
+        for (size_t i = 0; i < n; ++i) {
+            if (active_channels_[i]) {
+                active_channels_[i]->HandleEvent(poll_return_time_);
+            }
+        }
+        event_handling_ = false;
+        return;
+    }
+    // NOTE: 超出预算: 只处理 io_budget_ 个, 起点轮转, 其余的由下一轮 Poll 再次返回(水平触发)
+    size_t start = io_cursor_ % n;
+    for (size_t i = 0; i < io_budget_; ++i) {
+        if (Channel* channel = active_channels_[(start + i) % n]) {
+            channel->HandleEvent(poll_return_time_);
+        }
+    }
+    io_cursor_ = start + io_budget_;
+    has_leftover_ = true;
+    event_handling_ = false;
 }
 
 void EventLoop::Quit() {
@@ -82,45 +151,100 @@ bool EventLoop::IsInLoopThread() const {
     return thread_id_ == current_thread::Tid();
 }
 
-void EventLoop::RunInLoop(Functor cb) {
+void EventLoop::RunInLoop(Functor cb, Priority priority) {
     // 如果当前线程是 EventLoop 所在线程, 直接执行 cb
     if (IsInLoopThread()) {
         cb();
     }
     // 如果当前线程不是 EventLoop 所在线程, 把 cb 放入队列中, 唤醒 EventLoop 所在线程执行 cb
     else {
-        QueueInLoop(std::move(cb));
+        QueueInLoop(std::move(cb), priority);
     }
 }
 
-void EventLoop::QueueInLoop(Functor cb) {
-    {
-        std::unique_lock lk{mtx_};
-        pending_functors_.push_back(std::move(cb));
+void EventLoop::QueueInLoop(Functor cb, Priority priority) {
+    // NOTE: 无锁入队, 多个生产者线程不再争抢同一把 mutex
+    if (priority == Priority::kControl) {
+        control_functors_.Push(std::move(cb));
+    } else {
+        pending_functors_.Push(std::move(cb));
     }
 
     // 如果
-    // 1. 不在当前线程
-    // 2. 正在执行 pending_functors_ 中的回调函数
-    // 则唤醒 EventLoop 所在线程
-    if (!IsInLoopThread() || calling_pending_functors_) {
+    // 1. 不在当前线程: 唤醒 EventLoop 所在线程
+    // 2. 本线程正在执行 pending_functors_ 中的回调函数: 标记有剩余任务, 下一轮 Poll 不阻塞即可, 不必写 eventfd
+    if (!IsInLoopThread()) {
         Wakeup();
+    } else if (calling_pending_functors_) {
+        has_leftover_ = true;
     }
 }
 
 void EventLoop::DoPendingFunctors() {
-    std::vector<Functor> functors;
     calling_pending_functors_ = true;  // 标记正在执行 pending_functors_ 中的回调函数
-    // NOTE: 交换: 最小化锁的持有时间、避免死锁，提高并发性能
-    {
-        std::unique_lock lk{mtx_};
-        functors.swap(pending_functors_);
+    // NOTE: 队列深度在执行之前由消费端统计(已入队还未执行的任务数, 包括上一轮因预算留下的), Push 没有额外开销
+    EventLoopCounters::Max(counters_.pending_high_water,
+                           control_functors_.SizeApprox() + pending_functors_.SizeApprox());
+    size_t num_functors = 0;
+    WatchdogSlot* watchdog = this->watchdog();
+    // 1. 控制类任务: 每轮执行 **此刻已入队** 的全部任务, 不会被大量普通任务拖延
+    num_functors += control_functors_.ConsumeAll([&](Functor& functor) { RunFunctor(functor, watchdog); });
+
+    // 2. 普通任务: 执行 **此刻已入队** 的任务(执行期间新入队的留到下一轮), 受数量/时间预算限制
+    if (functor_budget_ == 0 && functor_time_budget_.count() == 0) {
+        num_functors += pending_functors_.ConsumeAll([&](Functor& functor) { RunFunctor(functor, watchdog); });
+    } else {
+        using Clock = std::chrono::steady_clock;
+        size_t max_functors = functor_budget_ ? functor_budget_ : std::numeric_limits<size_t>::max();
+        bool timed = functor_time_budget_.count() > 0;
+        auto deadline = Clock::now() + functor_time_budget_;
+        size_t n = 0;
+        num_functors += pending_functors_.ConsumeAtMost(max_functors, [&](Functor& functor) {
+            RunFunctor(functor, watchdog);
+            // NOTE: 每 16 个任务读一次时钟, 降低计时开销
+            return !timed || (++n & 15) != 0 || Clock::now() < deadline;
+        });
+        if (!pending_functors_.Empty()) {
+            has_leftover_ = true;
+        }
     }
-    // 依次执行 pending_functors_ 中的回调函数
-    for (const auto& functor : functors) {
+    EventLoopCounters::Add(counters_.functors, num_functors);
+    calling_pending_functors_ = false;
+}
+
+void EventLoop::RunFunctor(Functor& functor, WatchdogSlot* watchdog) {
+    if (!watchdog) {
         functor();
+        return;
     }
-    calling_pending_functors_ = false;
+    watchdog->Begin(CallbackPhase::kFunctor, -1);
+    functor();
+    if (int64_t elapsed_ns = watchdog->End()) {
+        LOG_WARNING("EventLoop %p slow functor finished after %ld ms\n", this, static_cast<long>(elapsed_ns / 1000000));
+    }
+}
+
+TimerId EventLoop::RunAfter(std::chrono::nanoseconds delay, Functor cb) {
+    return timer_queue_->AddTimer(std::move(cb), TimerQueue::Clock::now() + delay, TimerQueue::Clock::duration::zero());
+}
+
+TimerId EventLoop::RunEvery(std::chrono::nanoseconds interval, Functor cb) {
+    return timer_queue_->AddTimer(std::move(cb), TimerQueue::Clock::now() + interval, interval);
+}
+
+void EventLoop::CancelTimer(TimerId id) {
+    timer_queue_->Cancel(id);
+}
+
+void EventLoop::SetComputePool(ComputePool* pool) {
+    compute_pool_ = pool;
+}
+
+bool EventLoop::SubmitCompute(UniqueFunction<void()> task) {
+    if (!compute_pool_) {
+        LOG_FATAL("EventLoop %p Offload without a ComputePool, call SetComputePool first\n", this);
+    }
+    return compute_pool_->Submit(std::move(task));
 }
 
 void EventLoop::UpdateChannel(Channel* channel) {
@@ -128,6 +252,10 @@ void EventLoop::UpdateChannel(Channel* channel) {
 }
 
 void EventLoop::RemoveChannel(Channel* channel) {
+    if (event_handling_) {
+        // NOTE: 移除 Channel 通常发生在任务中, 只有在 IO 回调中直接移除时才需要线性查找
+        std::replace(active_channels_.begin(), active_channels_.end(), channel, static_cast<Channel*>(nullptr));
+    }
     poller_->RemoveChannel(channel);
 }
 
@@ -142,6 +270,14 @@ bool EventLoop::HasChannel(Channel* channel) {
 // ssize_t read(int fd, void *buf, size_t count);
 
 void EventLoop::Wakeup() {
+    // NOTE: 合并唤醒: 只有把 wakeup_pending_ 从 false 改为 true 的那个线程才真正写 eventfd
+    // 必须用 exchange(RMW) 而不是先 load 再判断: RMW 总是读到最新值, 保证与 HandleRead 中的清除构成同步,
+    // 生产者在 Wakeup 之前入队的任务对随后的 DoPendingFunctors 一定可见, 不会丢失唤醒
+    if (wakeup_pending_.exchange(true, std::memory_order_acq_rel)) {
+        suppressed_wakeups_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
     // 向 wakeup_fd_ 写 8 bytes 数据
     // wakeup_channel_ 触发 kReadEvent 当前 loop 线程就会被唤醒
     uint64_t one = 1;  // 8 bytes
@@ -159,6 +295,64 @@ void EventLoop::HandleRead() {
     if (n != sizeof(one)) {
         LOG_ERROR("EventLoop::HandleRead() reads %lu bytes instead of 8\n", n);
     }
+    // NOTE: 必须先 read 再清除标记: 若先清除, 期间其他线程写入的唤醒会被这次 read 吃掉,
+    // 标记却停留在 true, 之后所有唤醒都会被错误地合并掉
+    wakeup_pending_.exchange(false, std::memory_order_acq_rel);
+}
+
+void EventLoop::SetIoBudget(size_t max_channels) {
+    io_budget_ = max_channels;
+}
+
+void EventLoop::SetFunctorBudget(size_t max_functors, std::chrono::microseconds max_time) {
+    functor_budget_ = max_functors;
+    functor_time_budget_ = max_time;
+}
+
+EventLoopStats EventLoop::GetStats() const {
+    EventLoopStats stats;
+    stats.iterations = counters_.iterations.load(std::memory_order_relaxed);
+    stats.poll_events = counters_.poll_events.load(std::memory_order_relaxed);
+    stats.max_poll_events = counters_.max_poll_events.load(std::memory_order_relaxed);
+    stats.poll_ns = counters_.poll_ns.load(std::memory_order_relaxed);
+    stats.io_ns = counters_.io_ns.load(std::memory_order_relaxed);
+    stats.functor_ns = counters_.functor_ns.load(std::memory_order_relaxed);
+    stats.functors = counters_.functors.load(std::memory_order_relaxed);
+    stats.pending_high_water = counters_.pending_high_water.load(std::memory_order_relaxed);
+    stats.wakeups = wakeups();
+    stats.suppressed_wakeups = suppressed_wakeups();
+    stats.connections = connections();
+    stats.recent_busy_ns = counters_.recent_busy_ns.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t EventLoop::recent_latency_ns() const {
+    uint64_t busy = counters_.recent_busy_ns.load(std::memory_order_relaxed);
+    int64_t polling_since = counters_.polling_since_ns.load(std::memory_order_relaxed);
+    if (polling_since != 0 && static_cast<uint64_t>(NowNs() - polling_since) > busy) {
+        return 0;  // NOTE: 空闲: 新事件可以立即被处理; 否则滑动平均要等下一轮循环才会更新
+    }
+    return busy;
+}
+
+bool EventLoop::AttachWatchdog(std::shared_ptr<WatchdogSlot> slot) {
+    slot->loop = this;
+    slot->tid = thread_id_;
+    // NOTE: CAS 保证并发 Watch 时只有一个槽位生效; 槽位在发布前已初始化完毕
+    WatchdogSlot* expected = nullptr;
+    if (!watchdog_.compare_exchange_strong(expected, slot.get(), std::memory_order_acq_rel)) {
+        return false;
+    }
+    watchdog_slot_ = std::move(slot);  // 只在析构时使用
+    return true;
+}
+
+uint64_t EventLoop::wakeups() const {
+    return wakeups_.load(std::memory_order_relaxed);
+}
+
+uint64_t EventLoop::suppressed_wakeups() const {
+    return suppressed_wakeups_.load(std::memory_order_relaxed);
 }
 
 }  // namespace cutemuduo
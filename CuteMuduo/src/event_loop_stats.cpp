@@ -0,0 +1,39 @@
+#include <algorithm>
+#include <cstdio>
+//
+#include <cutemuduo/event_loop_stats.hpp>
+
+namespace cutemuduo {
+
+double EventLoopStats::EventsPerPoll() const {
+    return iterations ? static_cast<double>(poll_events) / static_cast<double>(iterations) : 0.0;
+}
+
+EventLoopStats& EventLoopStats::operator+=(EventLoopStats const& rhs) {
+    iterations += rhs.iterations;
+    poll_events += rhs.poll_events;
+    max_poll_events = std::max(max_poll_events, rhs.max_poll_events);
+    poll_ns += rhs.poll_ns;
+    io_ns += rhs.io_ns;
+    functor_ns += rhs.functor_ns;
+    functors += rhs.functors;
+    pending_high_water = std::max(pending_high_water, rhs.pending_high_water);
+    wakeups += rhs.wakeups;
+    suppressed_wakeups += rhs.suppressed_wakeups;
+    connections += rhs.connections;
+    recent_busy_ns = std::max(recent_busy_ns, rhs.recent_busy_ns);
+    return *this;
+}
+
+std::string EventLoopStats::ToString() const {
+    char buf[512] = {0};
+    snprintf(buf, sizeof(buf),
+             "iterations=%lu events/poll=%.2f max_events=%lu poll=%.3fms io=%.3fms functors=%.3fms "
+             "functors_run=%lu pending_high_water=%lu wakeups=%lu suppressed_wakeups=%lu connections=%lu "
+             "recent_busy=%.3fms",
+             iterations, EventsPerPoll(), max_poll_events, poll_ns / 1e6, io_ns / 1e6, functor_ns / 1e6, functors,
+             pending_high_water, wakeups, suppressed_wakeups, connections, recent_busy_ns / 1e6);
+    return buf;
+}
+
+}  // namespace cutemuduo
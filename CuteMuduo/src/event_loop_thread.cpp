@@ -1,14 +1,16 @@
+#include <cutemuduo/cpu_affinity.hpp>
 #include <cutemuduo/event_loop.hpp>
 #include <cutemuduo/event_loop_thread.hpp>
 
 namespace cutemuduo {
 
-EventLoopThread::EventLoopThread(ThreadInitCallback const& cb, std::string const& name)
+EventLoopThread::EventLoopThread(ThreadInitCallback const& cb, std::string const& name, int cpu)
     : loop_(nullptr),
       exiting_(false),
       thread_([this] { ThreadFunc(); },
               name),  // NOTE: 用 ThreadFunc 初始化线程对象(还未执行)要等 StartLoop() 调用
-      cb_(cb) {}
+      cb_(cb),
+      cpu_(cpu) {}
 
 EventLoopThread::~EventLoopThread() {
     exiting_ = true;
@@ -33,6 +35,10 @@ EventLoop* EventLoopThread::StartLoop() {
 }
 
 void EventLoopThread::ThreadFunc() {
+    // NOTE: 先绑核再创建 loop, 之后 loop 线程中首次访问(分配)的内存都落在本地 NUMA 节点上
+    if (cpu_ >= 0) {
+        cpu_affinity::PinCurrentThread(cpu_);
+    }
     EventLoop loop;  // NOTE: 创建局部 loop, 也即 one loop per thread 中的 loop
     if (cb_) {
         cb_(&loop);  // 执行用户自定义线程初始化回调函数
@@ -1,3 +1,4 @@
+#include <cutemuduo/event_loop.hpp>
 #include <cutemuduo/event_loop_thread.hpp>
 #include <cutemuduo/event_loop_thread_pool.hpp>
 
@@ -12,24 +13,44 @@ void EventLoopThreadPool::SetThreadNum(int num_threads) {
     num_threads_ = num_threads;
 }
 
+void EventLoopThreadPool::SetCpuAffinity(CpuAffinity affinity) {
+    affinity_ = std::move(affinity);
+}
+
 void EventLoopThreadPool::Start(ThreadInitCallback const& cb) {
     started_ = true;
 
+    std::vector<int> cpus = affinity_.Assign(num_threads_);
     for (int i{0}; i < num_threads_; ++i) {
         char* buf = new char[name_.size() + 32]{};
         snprintf(buf, name_.size() + 32, "%s%d", name_.c_str(), i);
-        auto t{std::make_unique<EventLoopThread>(cb, buf)};  // NOTE: 智能指针
-        loops_.push_back(t->StartLoop());                    // t->StartLoop() 将开启线程并启动事件循环(返回 loop 地址)
-        threads_.push_back(std::move(t));                    // 移动 unique_ptr
+        auto t{std::make_unique<EventLoopThread>(cb, buf, cpus[i])};  // NOTE: 智能指针
+        loops_.push_back(t->StartLoop());  // t->StartLoop() 将开启线程并启动事件循环(返回 loop 地址)
+        threads_.push_back(std::move(t));  // 移动 unique_ptr
         delete[] buf;
     }
 
+    if (policy_ && !loops_.empty()) {
+        policy_->Init(loops_);
+    }
+
     // HACK: 如果线程数为 0(其实这里不包括 base_loop_), 则直接在 base_loop 上执行回调
     if (num_threads_ == 0 && cb) {
         cb(base_loop_);
     }
 }
 
+void EventLoopThreadPool::SetDispatchPolicy(std::unique_ptr<DispatchPolicy> policy) {
+    policy_ = std::move(policy);
+}
+
+EventLoop* EventLoopThreadPool::GetLoopFor(InetAddress const& peer) {
+    if (!policy_ || loops_.empty()) {
+        return GetNextLoop();
+    }
+    return loops_[policy_->Select(loops_, peer)];
+}
+
 EventLoop* EventLoopThreadPool::GetNextLoop() {
     auto loop{base_loop_};
     if (!loops_.empty()) {
@@ -50,6 +71,22 @@ std::vector<EventLoop*> EventLoopThreadPool::GetAllLoops() const {
     }
 }
 
+EventLoopStats EventLoopThreadPool::GetStats() const {
+    EventLoopStats stats;
+    for (auto loop : GetAllLoops()) {
+        stats += loop->GetStats();
+    }
+    return stats;
+}
+
+std::vector<size_t> EventLoopThreadPool::GetConnectionCounts() const {
+    std::vector<size_t> counts;
+    for (auto loop : GetAllLoops()) {
+        counts.push_back(loop->connections());
+    }
+    return counts;
+}
+
 bool EventLoopThreadPool::started() const {
     return started_;
 }
@@ -0,0 +1,197 @@
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+//
+#include <cutemuduo/acceptor.hpp>
+#include <cutemuduo/channel.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/hot_restart.hpp>
+#include <cutemuduo/logger.hpp>
+#include <cutemuduo/tcp_server.hpp>
+
+namespace cutemuduo {
+
+static constexpr char kHandoffMessage = 'F';  // 旧进程 -> 新进程: 附带监听 socket
+static constexpr char kAckMessage = 'A';      // 新进程 -> 旧进程: 已经开始 accept
+static constexpr int kMaxHandoffFds = 253;    // 一条消息最多附带的 fd 数(SCM_MAX_FD)
+
+HotRestart::HotRestart(EventLoop* loop, InetAddress const& control_addr)
+    : loop_(loop),
+      control_addr_(control_addr),
+      server_(nullptr),
+      adopted_control_fd_(-1),
+      predecessor_fd_(-1),
+      handed_off_(false) {}
+
+HotRestart::~HotRestart() {
+    if (successor_channel_) {
+        CloseSuccessor();
+    }
+    if (predecessor_fd_ >= 0) {
+        close(predecessor_fd_);
+    }
+    if (adopted_control_fd_ >= 0) {
+        close(adopted_control_fd_);  // Takeover 之后没有 Serve
+    }
+}
+
+std::vector<int> HotRestart::Takeover(std::chrono::milliseconds timeout) {
+    int sockfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sockfd < 0) {
+        LOG_ERROR("%s:%s:%d socket err:%d\n", __FILE__, __FUNCTION__, __LINE__, errno);
+        return {};
+    }
+    if (connect(sockfd, control_addr_.GetSockAddr(), control_addr_.length()) < 0) {
+        LOG_INFO("HotRestart::Takeover - no running process on %s, cold start\n", control_addr_.ToIpPort().c_str());
+        close(sockfd);
+        return {};
+    }
+    timeval tv{};
+    tv.tv_sec = timeout.count() / 1000;
+    tv.tv_usec = (timeout.count() % 1000) * 1000;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    char message = 0;
+    iovec iov{&message, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxHandoffFds)];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n;
+    do {
+        // NOTE: MSG_CMSG_CLOEXEC: 收到的 fd 直接带上 FD_CLOEXEC, 不会泄漏给之后 fork/exec 的子进程
+        n = recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+
+    std::vector<int> fds;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); n > 0 && cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            size_t offset = fds.size();
+            fds.resize(offset + count);
+            memcpy(fds.data() + offset, CMSG_DATA(cmsg), count * sizeof(int));
+        }
+    }
+    if (n != 1 || message != kHandoffMessage || (msg.msg_flags & MSG_CTRUNC) || fds.empty()) {
+        LOG_ERROR("HotRestart::Takeover - handoff from %s failed (n=%zd errno=%d fds=%zu), cold start\n",
+                  control_addr_.ToIpPort().c_str(), n, errno, fds.size());
+        for (int fd : fds) {
+            close(fd);
+        }
+        close(sockfd);
+        return {};
+    }
+    LOG_INFO("HotRestart::Takeover - received %zu listen sockets from %s\n", fds.size() - 1,
+             control_addr_.ToIpPort().c_str());
+    adopted_control_fd_ = fds.front();
+    predecessor_fd_ = sockfd;
+    fds.erase(fds.begin());
+    return fds;
+}
+
+void HotRestart::Serve(TcpServer* server, HandoffCallback cb) {
+    server_ = server;
+    handoff_callback_ = std::move(cb);
+    loop_->RunInLoop([this] { ServeInLoop(); }, EventLoop::Priority::kControl);
+}
+
+void HotRestart::ServeInLoop() {
+    if (adopted_control_fd_ >= 0) {
+        control_acceptor_ = std::make_unique<Acceptor>(loop_, adopted_control_fd_);
+        adopted_control_fd_ = -1;
+    } else {
+        control_acceptor_ = std::make_unique<Acceptor>(loop_, control_addr_, false);
+    }
+    control_acceptor_->SetNewConnectionCallback([this](int connfd, InetAddress const&) { HandleSuccessor(connfd); });
+    control_acceptor_->Listen();
+
+    if (predecessor_fd_ >= 0) {
+        // NOTE: TcpServer::Start 已经开始 accept, 告诉旧进程可以停止了
+        if (send(predecessor_fd_, &kAckMessage, 1, MSG_NOSIGNAL) != 1) {
+            LOG_ERROR("HotRestart::Serve - ack to previous process err:%d\n", errno);
+        }
+        close(predecessor_fd_);
+        predecessor_fd_ = -1;
+    }
+}
+
+void HotRestart::HandleSuccessor(int connfd) {
+    if (handed_off_ || successor_channel_) {
+        // NOTE: 已经交出或正在交给另一个新进程, 直接关闭, 对方按冷启动处理(bind 会失败)
+        LOG_ERROR("HotRestart - reject concurrent takeover (handed_off=%d)\n", handed_off_);
+        close(connfd);
+        return;
+    }
+    std::vector<int> fds{control_acceptor_->listen_fd()};
+    for (int fd : server_->listen_fds()) {
+        fds.push_back(fd);
+    }
+    if (fds.size() > static_cast<size_t>(kMaxHandoffFds)) {
+        LOG_ERROR("HotRestart - too many listen sockets: %zu\n", fds.size());
+        close(connfd);
+        return;
+    }
+
+    char message = kHandoffMessage;
+    iovec iov{&message, 1};
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()));
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+    if (sendmsg(connfd, &msg, MSG_NOSIGNAL) != 1) {
+        LOG_ERROR("HotRestart - sendmsg listen sockets err:%d\n", errno);
+        close(connfd);
+        return;
+    }
+    LOG_INFO("HotRestart - sent %zu listen sockets to new process, waiting for ack\n", fds.size() - 1);
+
+    // NOTE: 等待确认期间两个进程都在 accept 同一个监听 socket, 连接由谁接受都可以
+    successor_channel_ = std::make_unique<Channel>(loop_, connfd);
+    successor_channel_->SetReadCallback([this](Timestamp) { HandleSuccessorRead(); });
+    successor_channel_->EnableReading();
+}
+
+void HotRestart::HandleSuccessorRead() {
+    char message = 0;
+    ssize_t n = read(successor_channel_->fd(), &message, 1);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    }
+    CloseSuccessor();
+    if (n != 1 || message != kAckMessage) {
+        // 新进程在确认之前退出: 继续服务, 交出去的 fd 副本随新进程退出关闭, 监听 socket 不受影响
+        LOG_ERROR("HotRestart - new process exited before ack (n=%zd), keep serving\n", n);
+        return;
+    }
+    handed_off_ = true;
+    server_->MarkListenSocketsHandedOff();
+    control_acceptor_->SetHandedOff();
+    control_acceptor_->Stop();
+    LOG_INFO("HotRestart - listen sockets handed off\n");
+    if (handoff_callback_) {
+        handoff_callback_();
+    }
+}
+
+void HotRestart::CloseSuccessor() {
+    int fd = successor_channel_->fd();
+    successor_channel_->DisableAll();
+    successor_channel_->Remove();
+    // NOTE: 可能正处于这个 Channel 的事件回调中, 延后到任务阶段再销毁
+    loop_->QueueInLoop([channel = std::move(successor_channel_)] {}, EventLoop::Priority::kControl);
+    close(fd);
+}
+
+}  // namespace cutemuduo
@@ -1,42 +1,111 @@
+#include <stddef.h>
 #include <string.h>
+
+#include <algorithm>
 //
 #include <cutemuduo/inet_address.hpp>
 
 namespace cutemuduo {
 
-InetAddress::InetAddress(uint16_t port, std::string ip) {
-    addr_.sin_family = AF_INET;
-    addr_.sin_port = htons(port);
-    inet_pton(AF_INET, ip.c_str(), &addr_.sin_addr);  // inet_pton: presentation to network
+InetAddress::InetAddress(uint16_t port, std::string ip) : addr_{} {
+    if (ip.find(':') != std::string::npos) {
+        auto addr6 = reinterpret_cast<sockaddr_in6*>(&addr_);
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons(port);
+        inet_pton(AF_INET6, ip.c_str(), &addr6->sin6_addr);
+        len_ = sizeof(sockaddr_in6);
+    } else {
+        auto addr4 = reinterpret_cast<sockaddr_in*>(&addr_);
+        addr4->sin_family = AF_INET;
+        addr4->sin_port = htons(port);
+        inet_pton(AF_INET, ip.c_str(), &addr4->sin_addr);  // inet_pton: presentation to network
+        len_ = sizeof(sockaddr_in);
+    }
+}
+
+InetAddress::InetAddress(sockaddr_in const& addr)
+    : InetAddress(reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) {}
+
+InetAddress::InetAddress(sockaddr_in6 const& addr)
+    : InetAddress(reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) {}
+
+InetAddress::InetAddress(sockaddr const* addr, socklen_t len) : addr_{}, len_(0) {
+    SetSockAddr(addr, len);
+}
+
+InetAddress InetAddress::UnixPath(std::string const& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    size_t n = std::min(path.size(), sizeof(addr.sun_path) - 1);  // NOTE: 保留结尾的 '\0'
+    memcpy(addr.sun_path, path.data(), n);
+    return InetAddress(reinterpret_cast<sockaddr const*>(&addr),
+                       static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + n + 1));
 }
 
-InetAddress::InetAddress(sockaddr_in const& addr) : addr_(addr) {}
+InetAddress InetAddress::UnixAbstract(std::string const& name) {
+    // NOTE: 抽象命名空间的地址以 '\0' 开头, 长度精确到名称末尾(后面不补 '\0')
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    size_t n = std::min(name.size(), sizeof(addr.sun_path) - 1);
+    memcpy(addr.sun_path + 1, name.data(), n);
+    return InetAddress(reinterpret_cast<sockaddr const*>(&addr),
+                       static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + n));
+}
 
 std::string InetAddress::ToIp() const {
-    char buf[64] = {0};
-    inet_ntop(AF_INET, &addr_.sin_addr, buf, sizeof(buf));
-    return buf;
+    char buf[INET6_ADDRSTRLEN] = {0};
+    switch (family()) {
+        case AF_INET:
+            inet_ntop(AF_INET, &reinterpret_cast<sockaddr_in const*>(&addr_)->sin_addr, buf, sizeof(buf));
+            return buf;
+        case AF_INET6:
+            inet_ntop(AF_INET6, &reinterpret_cast<sockaddr_in6 const*>(&addr_)->sin6_addr, buf, sizeof(buf));
+            return buf;
+        case AF_UNIX: {
+            auto addr = reinterpret_cast<sockaddr_un const*>(&addr_);
+            size_t n = len_ > offsetof(sockaddr_un, sun_path) ? len_ - offsetof(sockaddr_un, sun_path) : 0;
+            if (n == 0) {
+                return "";  // 未命名(如 accept 得到的对端地址)
+            }
+            if (addr->sun_path[0] == '\0') {
+                return "@" + std::string(addr->sun_path + 1, n - 1);
+            }
+            return std::string(addr->sun_path, strnlen(addr->sun_path, n));
+        }
+        default:
+            return "";
+    }
 }
 
 std::string InetAddress::ToIpPort() const {
-    char buf[64] = {0};
-    inet_ntop(AF_INET, &addr_.sin_addr, buf, sizeof(buf));
-    uint16_t port = ntohs(addr_.sin_port);
-    // TODO: snprintf?
-    snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf), ":%u", port);
-    return buf;
+    switch (family()) {
+        case AF_INET6:
+            return "[" + ToIp() + "]:" + std::to_string(ToPort());
+        case AF_UNIX:
+            return "unix:" + ToIp();
+        default:
+            return ToIp() + ":" + std::to_string(ToPort());
+    }
 }
 
 uint16_t InetAddress::ToPort() const {
-    return ntohs(addr_.sin_port);
+    switch (family()) {
+        case AF_INET:
+            return ntohs(reinterpret_cast<sockaddr_in const*>(&addr_)->sin_port);
+        case AF_INET6:
+            return ntohs(reinterpret_cast<sockaddr_in6 const*>(&addr_)->sin6_port);
+        default:
+            return 0;
+    }
 }
 
-const sockaddr_in* InetAddress::GetSockAddr() const {
-    return &addr_;
+sockaddr const* InetAddress::GetSockAddr() const {
+    return reinterpret_cast<sockaddr const*>(&addr_);
 }
 
-void InetAddress::SetSockAddr(sockaddr_in const& addr) {
-    addr_ = addr;
+void InetAddress::SetSockAddr(sockaddr const* addr, socklen_t len) {
+    len_ = std::min<socklen_t>(len, sizeof(addr_));
+    memcpy(&addr_, addr, len_);
 }
 
 }  // namespace cutemuduo
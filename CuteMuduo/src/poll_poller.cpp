@@ -0,0 +1,78 @@
+#include <cutemuduo/logger.hpp>
+#include <cutemuduo/poll_poller.hpp>
+
+namespace cutemuduo {
+
+PollPoller::PollPoller(EventLoop* loop) : Poller(loop) {}
+
+PollPoller::~PollPoller() = default;
+
+Timestamp PollPoller::Poll(int timeout_ms, ChannelList* active_channels) {
+    int num_events = poll(pollfds_.data(), pollfds_.size(), timeout_ms);
+    int saved_errno = errno;
+    Timestamp now(Timestamp::Now());
+
+    if (num_events > 0) {
+        FillActiveChannels(num_events, active_channels);
+    } else if (num_events < 0 && saved_errno != EINTR) {
+        LOG_ERROR("poll() error:%d\n", saved_errno);
+    }
+    return now;
+}
+
+void PollPoller::FillActiveChannels(int num_events, ChannelList* active_channels) const {
+    // NOTE: poll 只返回就绪 fd 的个数, 需要遍历 pollfds_ 找出 revents 非零的项
+    for (auto it = pollfds_.begin(); it != pollfds_.end() && num_events > 0; ++it) {
+        if (it->revents > 0) {
+            --num_events;
+            auto ch = channels_.find(it->fd);
+            Channel* channel = ch->second;
+            channel->SetRevents(it->revents);
+            active_channels->push_back(channel);
+        }
+    }
+}
+
+void PollPoller::UpdateChannel(Channel* channel) {
+    // 新的 channel: 追加到 pollfds_ 末尾, 并记录下标
+    if (channel->index() < 0) {
+        pollfd pfd{};
+        pfd.fd = channel->fd();
+        pfd.events = static_cast<short>(channel->events());
+        pollfds_.push_back(pfd);
+        channel->SetIndex(static_cast<int>(pollfds_.size()) - 1);
+        channels_[pfd.fd] = channel;
+    }
+    // 已存在的 channel: 原地修改感兴趣的事件
+    else {
+        pollfd& pfd = pollfds_[channel->index()];
+        pfd.fd = channel->fd();
+        pfd.events = static_cast<short>(channel->events());
+        pfd.revents = 0;
+        // NOTE: 没有感兴趣的事件时把 fd 置为负数, poll 会忽略该项(-fd-1 保证 fd=0 时也为负)
+        if (channel->IsNoneEvent()) {
+            pfd.fd = -channel->fd() - 1;
+        }
+    }
+}
+
+void PollPoller::RemoveChannel(Channel* channel) {
+    int index = channel->index();
+    channels_.erase(channel->fd());
+    if (index < 0) {
+        return;
+    }
+    // NOTE: 与末尾元素交换后 pop_back, 避免 O(n) 的 erase
+    if (static_cast<size_t>(index) != pollfds_.size() - 1) {
+        std::swap(pollfds_[index], pollfds_.back());
+        int moved_fd = pollfds_[index].fd;
+        if (moved_fd < 0) {
+            moved_fd = -moved_fd - 1;
+        }
+        channels_[moved_fd]->SetIndex(index);
+    }
+    pollfds_.pop_back();
+    channel->SetIndex(-1);  // -1: 还没添加
+}
+
+}  // namespace cutemuduo
@@ -1,3 +1,4 @@
+#include <linux/filter.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -19,8 +20,8 @@ int Socket::sockfd() const {
 }
 
 void Socket::BindAddress(InetAddress const& localaddr) {
-    // NOTE: 将const sockaddr_in* 强制转换为 sockaddr*
-    int ret = bind(sockfd_, (sockaddr*)localaddr.GetSockAddr(), sizeof(sockaddr_in));
+    // NOTE: 地址长度随地址族不同(IPv4/IPv6/Unix 域)
+    int ret = bind(sockfd_, localaddr.GetSockAddr(), localaddr.length());
     if (ret != 0) {
         printf("bind error\n");
     }
@@ -34,12 +35,12 @@ void Socket::Listen() {
 }
 
 int Socket::Accept(InetAddress* peeraddr) {  // NOTE: peeraddr: 对端地址
-    sockaddr_in addr;
+    sockaddr_storage addr;
     socklen_t addrlen = sizeof(addr);
     // NOTE: accept4() 与 accept() 的区别在于可以设置非阻塞和关闭连接时关闭文件描述符
     int connfd = accept4(sockfd_, reinterpret_cast<sockaddr*>(&addr), &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
     if (connfd >= 0) {
-        peeraddr->SetSockAddr(addr);  // HACK: InetAddress.addr_ 只能通过 SetSockAddr() 设置
+        peeraddr->SetSockAddr(reinterpret_cast<sockaddr*>(&addr), addrlen);  // HACK: 只能通过 SetSockAddr() 设置
     }
     return connfd;
 }
@@ -79,4 +80,23 @@ void Socket::SetKeepAlive(bool on) {
     setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof(optval));
 }
 
+bool Socket::AttachReusePortCpuFilter(int group_size) {
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+    if (group_size <= 0) {
+        return false;
+    }
+    // A = 当前 CPU; A %= group_size; return A
+    sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<__u32>(SKF_AD_OFF + SKF_AD_CPU)},
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<__u32>(group_size)},
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+    sock_fprog prog = {static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code};
+    return setsockopt(sockfd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) == 0;
+#else
+    (void)group_size;
+    return false;
+#endif
+}
+
 }  // namespace cutemuduo
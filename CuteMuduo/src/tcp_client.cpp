@@ -0,0 +1,138 @@
+#include <sys/socket.h>
+
+#include <utility>
+//
+#include <cutemuduo/block_pool.hpp>
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/connector.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/logger.hpp>
+#include <cutemuduo/tcp_client.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+
+namespace cutemuduo {
+
+static EventLoop* CheckLoopNotNull(EventLoop* loop) {
+    if (loop == nullptr) {
+        LOG_FATAL("%s:%s:%d loop is null!\n", __FILE__, __FUNCTION__, __LINE__);
+    }
+    return loop;
+}
+
+static InetAddress LocalAddressOf(int sockfd) {
+    sockaddr_storage local{};
+    socklen_t addrlen = sizeof(local);
+    if (getsockname(sockfd, reinterpret_cast<sockaddr*>(&local), &addrlen) < 0) {
+        LOG_ERROR("getsockname error\n");
+    }
+    return InetAddress{reinterpret_cast<sockaddr*>(&local), addrlen};
+}
+
+static InetAddress PeerAddressOf(int sockfd) {
+    sockaddr_storage peer{};
+    socklen_t addrlen = sizeof(peer);
+    if (getpeername(sockfd, reinterpret_cast<sockaddr*>(&peer), &addrlen) < 0) {
+        LOG_ERROR("getpeername error\n");
+    }
+    return InetAddress{reinterpret_cast<sockaddr*>(&peer), addrlen};
+}
+
+TcpClient::TcpClient(EventLoop* loop, InetAddress const& server_addr, std::string const& name)
+    : loop_(CheckLoopNotNull(loop)),
+      connector_(std::make_shared<Connector>(loop, server_addr)),
+      name_(name),
+      conn_name_prefix_(std::make_shared<std::string const>(name + "-" + server_addr.ToIpPort())),
+      connection_callback_([](TcpConnectionPtr const&) {}),
+      message_callback_([](TcpConnectionPtr const&, Buffer* buf, Timestamp) { buf->RetrieveAll(); }),
+      auto_reconnect_(false),
+      connect_(false),
+      next_conn_id_(1) {
+    connector_->SetNewConnectionCallback([this](int sockfd) { NewConnection(sockfd); });
+}
+
+TcpClient::~TcpClient() {
+    connector_->Stop();
+    TcpConnectionPtr conn_ptr;
+    {
+        std::lock_guard lk{mutex_};
+        conn_ptr = std::move(connection_);
+    }
+    if (conn_ptr) {
+        // NOTE: 连接可能比 TcpClient 活得久(用户还持有它), 关闭回调不能再指向 this
+        EventLoop* loop = loop_;
+        conn_ptr->SetCloseCallback([loop](TcpConnectionPtr const& conn) {
+            loop->RemoveConnection();
+            loop->QueueInLoop([conn] { conn->ConnectDestroyed(); }, EventLoop::Priority::kControl);
+        });
+        conn_ptr->ForceClose();
+    }
+}
+
+void TcpClient::SetRetryDelay(std::chrono::milliseconds initial, std::chrono::milliseconds max) {
+    connector_->SetRetryDelay(initial, max);
+}
+
+void TcpClient::Connect() {
+    LOG_INFO("TcpClient::Connect [%s] - connecting to %s\n", name_.c_str(),
+             connector_->server_address().ToIpPort().c_str());
+    connect_ = true;
+    connector_->Start();
+}
+
+void TcpClient::Disconnect() {
+    connect_ = false;
+    if (auto conn_ptr = connection()) {
+        conn_ptr->Shutdown();
+    }
+}
+
+void TcpClient::Stop() {
+    connect_ = false;
+    connector_->Stop();
+}
+
+TcpConnectionPtr TcpClient::connection() const {
+    std::lock_guard lk{mutex_};
+    return connection_;
+}
+
+void TcpClient::NewConnection(int sockfd) {
+    uint64_t conn_id = next_conn_id_++;
+    InetAddress peer_addr = PeerAddressOf(sockfd);
+    LOG_INFO("TcpClient::NewConnection [%s] - new connection [%s#%lu] to %s\n", name_.c_str(),
+             conn_name_prefix_->c_str(), conn_id, peer_addr.ToIpPort().c_str());
+    // NOTE: 与 TcpServer 一样, 控制块和 TcpConnection 一次分配, 来自 loop 线程的 block_pool
+    auto conn_ptr{std::allocate_shared<TcpConnection>(BlockAllocator<TcpConnection>(), loop_, conn_id,
+                                                      conn_name_prefix_, sockfd, LocalAddressOf(sockfd), peer_addr)};
+    conn_ptr->SetConnectionCallback(connection_callback_);
+    conn_ptr->SetMessageCallback(message_callback_);
+    conn_ptr->SetWriteCompleteCallback(write_complete_callback_);
+    conn_ptr->SetCloseCallback([this](TcpConnectionPtr const& conn) { RemoveConnection(conn); });
+    {
+        std::lock_guard lk{mutex_};
+        connection_ = conn_ptr;
+    }
+    loop_->AddConnection();  // NOTE: 与 TcpServer 的连接一起计入 loop 的连接数(见 EventLoop::connections)
+    conn_ptr->ConnectEstablished();
+}
+
+void TcpClient::RemoveConnection(TcpConnectionPtr const& conn_ptr) {
+    {
+        std::lock_guard lk{mutex_};
+        if (connection_ == conn_ptr) {
+            connection_.reset();
+        }
+    }
+    loop_->RemoveConnection();
+    // NOTE: 正处于该连接 Channel 的回调中, 销毁放到本轮任务中执行(同 TcpServer::RemoveConnectionInLoop)
+    loop_->QueueInLoop([conn_ptr] { conn_ptr->ConnectDestroyed(); }, EventLoop::Priority::kControl);
+    // NOTE: 无论是否自动重连都要让 Connector 回到 kDisconnected, 否则之后的 Connect() 不会发起新的连接
+    connector_->Disconnected();
+    if (auto_reconnect_ && connect_) {
+        LOG_INFO("TcpClient::RemoveConnection [%s] - reconnecting to %s\n", name_.c_str(),
+                 connector_->server_address().ToIpPort().c_str());
+        connector_->Restart();
+    }
+}
+
+}  // namespace cutemuduo
@@ -1,4 +1,7 @@
+#include <sys/ioctl.h>
+//
 #include <cutemuduo/channel.hpp>
+#include <cutemuduo/coroutine.hpp>
 #include <cutemuduo/event_loop.hpp>
 #include <cutemuduo/logger.hpp>
 #include <cutemuduo/socket.hpp>
@@ -10,6 +13,9 @@ namespace cutemuduo {
 // 马上能做的用 RunInLoop
 // 怕递归、怕回调、怕死循环的用 QueueInLoop
 
+// NOTE: 投递到 loop 的任务一律捕获 shared_from_this() 而不是 this
+// kControl 任务(ConnectDestroyed)会先于更早入队的 kBulk 任务执行, 捕获 this 可能悬垂
+
 // 检查 EventLoop 是否为空
 static EventLoop* CheckLoopNotNull(EventLoop* loop) {
     if (!loop) {
@@ -18,58 +24,77 @@ static EventLoop* CheckLoopNotNull(EventLoop* loop) {
     return loop;
 }
 
-TcpConnection::TcpConnection(EventLoop* loop, std::string const& name_arg, int sockfd, InetAddress const& local_addr,
-                             InetAddress const& peer_addr)
+TcpConnection::TcpConnection(EventLoop* loop, uint64_t id, std::shared_ptr<std::string const> name_prefix, int sockfd,
+                             InetAddress const& local_addr, InetAddress const& peer_addr)
     : loop_(CheckLoopNotNull(loop)),
-      name_(name_arg),
+      id_(id),
+      name_prefix_(std::move(name_prefix)),
       state_(StateE::kConnecting),
       reading_(true),
-      socket_(std::make_unique<Socket>(sockfd)),
-      channel_(std::make_unique<Channel>(loop, sockfd)),
+      draining_(false),
+      received_(false),
+      socket_(sockfd),
+      channel_(loop, sockfd),
       local_addr_(local_addr),
       peer_addr_(peer_addr),
-      high_water_mark_(64 * 1024 * 1024) {
-    // NOTE: TcpConnection 的构造函数中**注册** Channel 的回调函数
-    channel_->SetReadCallback([this](Timestamp receive_time) { this->HandleRead(receive_time); });
-    channel_->SetWriteCallback([this]() { this->HandleWrite(); });
-    channel_->SetCloseCallback([this]() { this->HandleClose(); });
-    channel_->SetErrorCallback([this]() { this->HandleError(); });
-
-    LOG_INFO("TcpConnection::ctor[%s] at fd=%d\n", name_.c_str(), sockfd);
-
-    socket_->SetKeepAlive(true);  // NOTE: 开启 TCP KeepAlive
+      high_water_mark_(64 * 1024 * 1024),
+      read_waiter_(nullptr),
+      write_waiter_(nullptr),
+      coroutine_reading_(false) {
+    // NOTE: TcpConnection 的构造函数中**注册** Channel 的事件处理者(不经过 std::function 和 Tie)
+    channel_.SetHandler(this);
+    channel_.SetOwnerName(
+        [](void const* owner) -> std::string const& { return static_cast<TcpConnection const*>(owner)->GetName(); },
+        this);
+
+    LOG_INFO("TcpConnection::ctor[%s#%lu] at fd=%d\n", name_prefix_->c_str(), id_, sockfd);
+
+    socket_.SetKeepAlive(true);  // NOTE: 开启 TCP KeepAlive
 }
 
 TcpConnection::~TcpConnection() {
-    LOG_INFO("TcpConnection::dtor[%s] at fd=%d state=%s\n", name_.c_str(), channel_->fd(), StateToString().c_str());
+    LOG_INFO("TcpConnection::dtor[%s#%lu] at fd=%d state=%s\n", name_prefix_->c_str(), id_, channel_.fd(),
+             StateToString().c_str());
 }
 
 void TcpConnection::SetState(StateE const& new_s) { state_ = new_s; }
 
 void TcpConnection::ConnectEstablished() {
     SetState(StateE::kConnected);
-    channel_->Tie(shared_from_this());         // NOTE: 用于保证 TcpConnection 对象在 channel 中的生命周期
-    channel_->EnableReading();                 // 开启 channel 的读事件监听(注册 EPOLLIN)
+    channel_.EnableReading();                  // 开启 channel 的读事件监听(注册 EPOLLIN)
     connection_callback_(shared_from_this());  // 新连接建立回调
 }
 
 void TcpConnection::ConnectDestroyed() {
     if (state_ == StateE::kConnected) {
         SetState(StateE::kDisconnected);
-        channel_->DisableAll();
+        channel_.DisableAll();
+        ResumeWaiters();
         connection_callback_(shared_from_this());
     }
-    channel_->Remove();
+    channel_.Remove();
 }
 
 void TcpConnection::HandleRead(Timestamp receive_time) {
     int savedErrno = 0;
     // 从 fd 中读取数据进 input_buffer_
-    ssize_t n = input_buffer_.ReadFd(channel_->fd(), &savedErrno);  // NOTE: 读数据是可读回调函数的主要任务
+    ssize_t n = input_buffer_.ReadFd(channel_.fd(), &savedErrno);  // NOTE: 读数据是可读回调函数的主要任务
     // NOTE: 接收到数据后, 调用用户自定义的收到消息(数据)后的回调函数
     // 不需要加入 loop_ 的 pending_functors_ 任务队列中
     if (n > 0) {
-        message_callback_(shared_from_this(), &input_buffer_, receive_time);
+        bool first = !std::exchange(received_, true);
+        // 协程读取的连接: 条件满足时恢复等待的协程, 不调用 message_callback_
+        if (read_waiter_) {
+            if (read_waiter_->Ready()) {
+                std::exchange(read_waiter_, nullptr)->handle_.resume();
+            }
+        } else if (!coroutine_reading_) {
+            message_callback_(shared_from_this(), &input_buffer_, receive_time);
+        }
+        // 优雅关闭时还在等第一个请求的连接(见 DrainAndClose): 请求已经交给上层, 可以结束了
+        if (draining_ && first && state_ == StateE::kConnected) {
+            FinishDraining();
+        }
     }
     // 客户端断开
     else if (n == 0) {
@@ -84,49 +109,65 @@ void TcpConnection::HandleRead(Timestamp receive_time) {
 }
 
 void TcpConnection::HandleWrite() {
-    if (channel_->IsWriting()) {
+    if (channel_.IsWriting()) {
         int saved_errno = 0;
         // 将 output_buffer_ 中的 **可读空间中所有数据** 写入 fd
-        ssize_t n = output_buffer_.WriteFd(channel_->fd(), &saved_errno);
+        ssize_t n = output_buffer_.WriteFd(channel_.fd(), &saved_errno);
         if (n > 0) {
             if (output_buffer_.ReadableBytes() == 0) {  // 如果此时 output_buffer_ 中的数据已经全部发送完毕
-                channel_->DisableWriting();             // 关闭可写事件监听
+                channel_.DisableWriting();              // 关闭可写事件监听
                 if (write_complete_callback_) {
                     // NOTE: 将 write_complete_callback_ 放入 loop_ 的 pending_functors_ 任务队列中
                     // HACK: 防止用户回调 write_complete_callback_ 调用 Send() 再次触发 HandleWrite() 造成递归调用栈溢出
-                    loop_->QueueInLoop([this] { write_complete_callback_(shared_from_this()); });
+                    loop_->QueueInLoop([self = shared_from_this()] { self->write_complete_callback_(self); });
                 }
                 if (state_ == StateE::kDisconnecting) {
                     ShutdownInLoop();  // 在当前 loop 中关闭连接
                 }
+                if (write_waiter_) {
+                    std::exchange(write_waiter_, nullptr)->handle_.resume();
+                }
+                if (draining_ && !channel_.IsReading() && state_ != StateE::kDisconnected) {
+                    HandleClose();  // 优雅关闭: 已经不再读, 最后的响应也已发送完毕
+                }
             } else {
                 LOG_ERROR("TcpConnection::HandleWrite");
             }
         } else {
-            LOG_ERROR("TcpConnection fd=%d is down, no more writing", channel_->fd());
+            LOG_ERROR("TcpConnection fd=%d is down, no more writing", channel_.fd());
         }
     }
 }
 
 void TcpConnection::HandleClose() {
-    LOG_INFO("TcpConnection::HandleClose fd=%d state=%s\n", channel_->fd(), StateToString().c_str());
+    LOG_INFO("TcpConnection::HandleClose fd=%d state=%s\n", channel_.fd(), StateToString().c_str());
     SetState(StateE::kDisconnected);
-    channel_->DisableAll();
+    channel_.DisableAll();
     TcpConnectionPtr conn_ptr{shared_from_this()};  // 防止函数执行结束前, 对象被销毁
+    ResumeWaiters();
     connection_callback_(conn_ptr);                 // TODO: 用于通知上层应用连接状态的变化
     close_callback_(conn_ptr);                      // TODO: 用于通知 TcpServer 进行清理工作
 }
 
+void TcpConnection::ResumeWaiters() {
+    if (read_waiter_) {
+        std::exchange(read_waiter_, nullptr)->handle_.resume();
+    }
+    if (write_waiter_) {
+        std::exchange(write_waiter_, nullptr)->handle_.resume();
+    }
+}
+
 void TcpConnection::HandleError() {
     int optval;
     socklen_t optlen = sizeof(optval);
     int err = 0;
-    if (getsockopt(channel_->fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0) {
+    if (getsockopt(channel_.fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0) {
         err = errno;
     } else {
         err = optval;
     }
-    LOG_ERROR("TcpConnection::HandleError name:%s - SO_ERROR:%d\n", name_.c_str(), err);
+    LOG_ERROR("TcpConnection::HandleError name:%s#%lu - SO_ERROR:%d\n", name_prefix_->c_str(), id_, err);
 }
 
 void TcpConnection::SetConnectionCallback(ConnectionCallback cb) { connection_callback_ = std::move(cb); }
@@ -164,7 +205,18 @@ void TcpConnection::Send(std::string const& msg) {
             SendInLoop(msg.c_str(), msg.size());
         } else {  // 多 Reactor, 用户调用 conn->Send 时, loop_ 不在当前线程
             // NOTE: 选 RunInLoop 原因: 如果是自己线程, 最好立即发
-            loop_->RunInLoop([this, msg] { SendInLoop(msg.c_str(), msg.size()); });
+            loop_->RunInLoop([self = shared_from_this(), msg] { self->SendInLoop(msg.c_str(), msg.size()); });
+        }
+    }
+}
+
+void TcpConnection::Send(std::string&& msg) {
+    if (state_ == StateE::kConnected) {
+        if (loop_->IsInLoopThread()) {
+            SendInLoop(msg.c_str(), msg.size());
+        } else {
+            loop_->RunInLoop(
+                [self = shared_from_this(), msg = std::move(msg)] { self->SendInLoop(msg.c_str(), msg.size()); });
         }
     }
 }
@@ -175,8 +227,8 @@ void TcpConnection::Send(Buffer* buffer) {
             SendInLoop(buffer->Peek(), buffer->ReadableBytes());
             buffer->RetrieveAll();
         } else {
-            loop_->RunInLoop([this, buffer] {
-                SendInLoop(buffer->Peek(), buffer->ReadableBytes());
+            loop_->RunInLoop([self = shared_from_this(), buffer] {
+                self->SendInLoop(buffer->Peek(), buffer->ReadableBytes());
                 buffer->RetrieveAll();
             });
         }
@@ -193,13 +245,13 @@ void TcpConnection::SendInLoop(void const* data, size_t len) {
     bool fault_error = false;  // 记录是否产生过错误
 
     // 当 channel_ 没有注册可写事件并且 outputBuffer_ 中没有待发送数据, 则直接将 data 中的数据发送出去
-    if (!channel_->IsWriting() && output_buffer_.ReadableBytes() == 0) {
-        nwrote = write(channel_->fd(), data, len);
+    if (!channel_.IsWriting() && output_buffer_.ReadableBytes() == 0) {
+        nwrote = write(channel_.fd(), data, len);
         if (nwrote >= 0) {
             remaining = len - nwrote;
             // 消息发送完毕, 调用用户自定义的发送完消息后的回调函数
             if (remaining == 0 && write_complete_callback_) {
-                loop_->QueueInLoop([this] { write_complete_callback_(shared_from_this()); });
+                loop_->QueueInLoop([self = shared_from_this()] { self->write_complete_callback_(self); });
             }
         } else {  // nwrote<0
             nwrote = 0;
@@ -219,23 +271,89 @@ void TcpConnection::SendInLoop(void const* data, size_t len) {
         if (old_len + remaining >= high_water_mark_ && old_len < high_water_mark_ && high_water_mark_callback_) {
             // 如果要发送的数据长度超过了高水位标记, 则调用用户自定义的高水位标记回调函数
             // NOTE: 按值捕获局部变量!!
-            loop_->QueueInLoop(
-                [old_len, remaining, this] { high_water_mark_callback_(shared_from_this(), old_len + remaining); });
+            loop_->QueueInLoop([self = shared_from_this(), old_len, remaining] {
+                self->high_water_mark_callback_(self, old_len + remaining);
+            });
         }
         // 将 data 中的数据追加到 outputBuffer_ 中
         output_buffer_.Append(static_cast<char const*>(data) + nwrote, remaining);
-        if (!channel_->IsWriting()) {
-            channel_->EnableWriting();  // NOTE: 开启 channel 的可写事件监听
+        if (!channel_.IsWriting()) {
+            channel_.EnableWriting();  // NOTE: 开启 channel 的可写事件监听
         }
     }
 }
 
+ReadAwaiter TcpConnection::Read(size_t n) {
+    coroutine_reading_ = true;
+    return ReadAwaiter(this, n, {});
+}
+
+ReadAwaiter TcpConnection::ReadUntil(std::string delim) {
+    coroutine_reading_ = true;
+    return ReadAwaiter(this, 0, std::move(delim));
+}
+
+WriteAwaiter TcpConnection::Write(std::string const& data) {
+    SendInLoop(data.data(), data.size());
+    return WriteAwaiter(this);
+}
+
+WriteAwaiter TcpConnection::Write(Buffer* buffer) {
+    SendInLoop(buffer->Peek(), buffer->ReadableBytes());
+    buffer->RetrieveAll();
+    return WriteAwaiter(this);
+}
+
+void TcpConnection::DrainAndClose() {
+    loop_->RunInLoop([self = shared_from_this()] {
+        if (self->state_ == StateE::kDisconnected) {
+            return;
+        }
+        self->draining_ = true;
+        // 1. 已经到达 socket 但还没读的请求先交给上层, 它们的响应也会发送
+        int unread = 0;
+        while (self->state_ == StateE::kConnected && ::ioctl(self->channel_.fd(), FIONREAD, &unread) == 0 &&
+               unread > 0) {
+            self->HandleRead(Timestamp::Now());
+        }
+        // NOTE: 刚建立还没收到过数据的连接不算空闲: 对端的第一个请求可能还在路上(例如 connect 返回后才 write),
+        // 这时关闭对端只会看到请求失败; 继续读, 第一个请求到达后(见 HandleRead)再结束, 一直不来由上层超时强制关闭
+        if (self->state_ == StateE::kDisconnected || !self->received_) {
+            return;
+        }
+        self->FinishDraining();
+    });
+}
+
+void TcpConnection::FinishDraining() {
+    // 不再读; 输出缓冲区为空时立即关闭, 否则等 HandleWrite 发送完毕后关闭(超时由上层强制关闭)
+    channel_.DisableReading();
+    if (!channel_.IsWriting()) {
+        HandleClose();
+    }
+}
+
+void TcpConnection::ForceClose() {
+    loop_->RunInLoop(
+        [self = shared_from_this()] {
+            if (self->state_ != StateE::kDisconnected) {
+                self->HandleClose();
+            }
+        },
+        EventLoop::Priority::kControl);
+}
+
+void TcpConnection::SetTcpNoDelay(bool on) { socket_.SetTcpNoDelay(on); }
+
 // TODO: SendFile
 // TODO: SendFileInLoop
 
 EventLoop* TcpConnection::GetLoop() const { return loop_; }
 
-std::string const& TcpConnection::GetName() const { return name_; }
+std::string const& TcpConnection::GetName() const {
+    std::call_once(name_once_, [this] { name_ = *name_prefix_ + "#" + std::to_string(id_); });
+    return name_;
+}
 
 InetAddress const& TcpConnection::GetLocalAddress() const { return local_addr_; }
 
@@ -247,13 +365,13 @@ void TcpConnection::Shutdown() {
     if (state_ == StateE::kConnected) {
         SetState(StateE::kDisconnecting);  // 标记 **正在** 断开连接
         // NOTE: 用 RunInLoop 原因: 尽快关闭
-        loop_->RunInLoop([this] { ShutdownInLoop(); });
+        loop_->RunInLoop([self = shared_from_this()] { self->ShutdownInLoop(); });
     }
 }
 
 void TcpConnection::ShutdownInLoop() {
-    if (!channel_->IsWriting()) {  // 如果当前 channel 没有写事件, 说明 output_buffer_ 数据已经发送完毕
-        socket_->ShutdownWrite();  // 调用 socket_ 的 ShutdownWrite() 关闭写端
+    if (!channel_.IsWriting()) {  // 如果当前 channel 没有写事件, 说明 output_buffer_ 数据已经发送完毕
+        socket_.ShutdownWrite();  // 调用 socket_ 的 ShutdownWrite() 关闭写端
     }
 }
 
@@ -1,4 +1,10 @@
+#include <unistd.h>
+
+#include <atomic>
+#include <future>
+//
 #include <cutemuduo/acceptor.hpp>
+#include <cutemuduo/block_pool.hpp>
 #include <cutemuduo/event_loop.hpp>
 #include <cutemuduo/event_loop_thread_pool.hpp>
 #include <cutemuduo/inet_address.hpp>
@@ -8,6 +14,9 @@
 
 namespace cutemuduo {
 
+// 超过最大连接数时多久检查一次(不知道什么时候会有连接关闭)
+static constexpr std::chrono::milliseconds kMaxConnectionsRetryDelay{10};
+
 static EventLoop* CheckLoopNotNull(EventLoop* loop) {
     if (loop == nullptr) {
         LOG_FATAL("%s:%s:%d mainLoop is null!\n", __FILE__, __FUNCTION__, __LINE__);
@@ -15,86 +24,426 @@ static EventLoop* CheckLoopNotNull(EventLoop* loop) {
     return loop;
 }
 
+struct TcpServer::ConnectionShard {
+    EventLoop* loop;                     // 所属的 loop
+    ConnectionMap connections;           // 该 loop 上的连接
+    std::unique_ptr<Acceptor> acceptor;  // kReusePortPerLoop: 该 loop 上的 Acceptor
+    bool stopping = false;               // 正在停止: 新登记的连接也立即优雅关闭
+    bool stopped = false;                // 已经通知 Mainloop 停止完成
+};
+
 TcpServer::TcpServer(EventLoop* loop, InetAddress const& listen_addr, std::string const& name, Option const& option)
     : loop_(CheckLoopNotNull(loop)),
       ip_port_(listen_addr.ToIpPort()),
       name_(name),
-      acceptor_(std::make_unique<Acceptor>(loop, listen_addr, option == Option::kReusePort)),
+      listen_addr_(listen_addr),
+      option_(option),
+      cpu_steering_(false),
+      accept_batch_(Acceptor::kDefaultAcceptBatch),
       thread_pool_(std::make_shared<EventLoopThreadPool>(loop, name)),
       num_threads_(0),
       started_(false),
-      next_conn_id_(1) {
-    // 为 Acceptor 设置新连接回调函数
-    // 有新连接时, Acceptor::HandleRead() 会执行 TcpServer::NewConnection() 同时传入 connfd 和 peer_addr
-    acceptor_->SetNewConnectionCallback(
-        [this](int connfd, InetAddress const& peer_addr) { NewConnection(connfd, peer_addr); });
-}
+      conn_name_prefix_(std::make_shared<std::string const>(name + "-" + ip_port_)),
+      next_conn_id_(1),
+      max_connections_(0),
+      overload_action_(Acceptor::OverloadAction::kPauseAccept),
+      num_connections_(0),
+      acceptor_counters_(std::make_shared<AcceptorCounters>()),
+      stopping_(false),
+      shards_stopping_(0),
+      stopped_(false),
+      drained_(true),
+      alive_(std::make_shared<bool>(true)) {}
 
 TcpServer::~TcpServer() {
     // NOTE: 设计哲学: 在 TcpConnection 自己的 loop 中调用 ConnectDestroyed
     // 且要保持先移除连接, 再销毁连接的顺序
-    for (auto& [name, conn_ptr] : connections_) {
-        auto conn_ptr_tmp{conn_ptr};  // 引用计数 +1
-        conn_ptr.reset();             // NOTE: 指针置空(但由于引用计数不为 0, 因此不会析构对象)
-        // HACK: conn_ptr_tmp 是局部变量, 离开作用域会销毁, 必须按值捕获!
-        // 否则调用 conn_ptr_tmp->ConnectDestroyed() 会导致 conn_ptr_tmp 为悬垂指针, 未定义行为
-        conn_ptr_tmp->GetLoop()->RunInLoop([conn_ptr_tmp] { conn_ptr_tmp->ConnectDestroyed(); });
+    // NOTE: 应在 Mainloop 线程中(或 Mainloop 退出之后)析构: Mainloop 上已经排队的任务/定时器看到 alive_ 失效后不再执行
+    alive_.reset();
+    loop_->CancelTimer(stop_timer_);  // Stop 还没完成时
+    stop_timer_ = TimerId{};
+    if (stopped_ && num_threads_ > 0) {
+        // Stop 已经完成: 连接表都已清空, Subloop 正在/已经退出(不能再访问它们), 退出任务不访问 TcpServer
+        return;
+    }
+    // 连接表和 Acceptor 只能在所属的 loop 线程中访问, 而 Acceptor 的回调、连接的关闭回调都捕获了 this:
+    // 依次在各自的 loop 线程中销毁并等待完成, 析构函数返回后不会再有回调访问 TcpServer
+    // NOTE: 同一 lane 内 FIFO, Mainloop 此前投递的 NewConnectionInShard 任务先于销毁任务执行(看到 alive_ 失效后丢弃连接);
+    // 已经排队的 ConnectDestroyed 任务不访问 TcpServer, 可以在析构之后执行
+    for (auto& shard : shards_) {
+        TeardownShard(shard.get());
+    }
+}
+
+void TcpServer::TeardownShard(ConnectionShard* shard) {
+    // NOTE: 投递的任务和当前线程谁先认领谁销毁: loop 在等待期间退出(或从未开始事件循环)时任务不会执行,
+    // 此时不会再有回调并发访问 shard, 由当前线程销毁
+    auto claimed = std::make_shared<std::atomic<bool>>(false);
+    auto torn_down = std::make_shared<std::promise<void>>();
+    auto future = torn_down->get_future();
+    shard->loop->RunInLoop(
+        [shard, claimed, torn_down] {
+            if (!claimed->exchange(true)) {
+                TeardownShardInLoop(shard);
+            }
+            torn_down->set_value();
+        },
+        EventLoop::Priority::kControl);
+    while (future.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
+        if (!shard->loop->looping() && !claimed->exchange(true)) {
+            TeardownShardInLoop(shard);
+            return;
+        }
+    }
+}
+
+void TcpServer::TeardownShardInLoop(ConnectionShard* shard) {
+    shard->acceptor.reset();  // 从 Poller 中移除, 不再接受新连接
+    ConnectionMap connections;
+    connections.swap(shard->connections);  // 先移除连接
+    shard->loop->RemoveConnection(connections.size());
+    for (auto& [id, conn_ptr] : connections) {
+        conn_ptr->ConnectDestroyed();  // 再销毁连接(从 Poller 中移除, 不会再调用关闭回调)
     }
 }
 
 void TcpServer::Start() {
     // HACK: +1 == 0? 防止 TcpServer 被启动多次
     if (started_.fetch_add(1) == 0) {
-        thread_pool_->Start(thread_init_callback_);         // 启动线程池(其实是开启 num_threads_ 个 Subloop)
-        loop_->RunInLoop([this] { acceptor_->Listen(); });  // NOTE: 当前就是 Mainloop, 只需要启动 Acceptor 的监听
+        thread_pool_->Start(thread_init_callback_);  // 启动线程池(其实是开启 num_threads_ 个 Subloop)
+        // 每个 loop 一份连接表(线程数为 0 时只有 Mainloop 一份)
+        for (auto io_loop : thread_pool_->GetAllLoops()) {
+            auto shard = std::make_unique<ConnectionShard>();
+            shard->loop = io_loop;
+            shards_.push_back(std::move(shard));
+        }
+        // NOTE: Unix 域 socket 没有 SO_REUSEPORT 分组, 总是由 Mainloop 上的 Acceptor 接受连接
+        if (option_ == Option::kReusePortPerLoop && num_threads_ > 0 && listen_addr_.family() != AF_UNIX) {
+            StartLoopAcceptors();
+        } else {
+            acceptor_ = CreateAcceptor(loop_, option_ != Option::kNoReusePort);
+            ConfigureAcceptor(acceptor_.get());
+            // 为 Acceptor 设置新连接回调函数
+            // 有新连接时, Acceptor::HandleRead() 会执行 TcpServer::NewConnection() 同时传入 connfd 和 peer_addr
+            acceptor_->SetNewConnectionCallback(
+                [this](int connfd, InetAddress const& peer_addr) { NewConnection(connfd, peer_addr); });
+            // NOTE: 当前就是 Mainloop, 只需要启动 Acceptor 的监听
+            loop_->RunInLoop(
+                [this, alive = std::weak_ptr(alive_)] {
+                    if (!alive.expired()) {
+                        acceptor_->Listen();
+                    }
+                },
+                EventLoop::Priority::kControl);
+        }
+        for (int fd : adopted_fds_) {
+            // NOTE: 关闭后这个 socket 的 accept 队列中的连接会被重置(热重启前后 Subloop 数量应当一致)
+            LOG_ERROR("TcpServer::Start [%s] - adopted listen fd=%d is not used, closing\n", name_.c_str(), fd);
+            close(fd);
+        }
+        adopted_fds_.clear();
     }
 }
 
+std::unique_ptr<Acceptor> TcpServer::CreateAcceptor(EventLoop* io_loop, bool reuse_port) {
+    if (adopted_fds_.empty()) {
+        return std::make_unique<Acceptor>(io_loop, listen_addr_, reuse_port);
+    }
+    int fd = adopted_fds_.front();
+    adopted_fds_.erase(adopted_fds_.begin());
+    return std::make_unique<Acceptor>(io_loop, fd);
+}
+
+void TcpServer::StartLoopAcceptors() {
+    for (auto& shard : shards_) {
+        auto raw_shard = shard.get();
+        shard->acceptor = CreateAcceptor(shard->loop, true);
+        ConfigureAcceptor(shard->acceptor.get());
+        shard->acceptor->SetNewConnectionCallback([this, raw_shard](int connfd, InetAddress const& peer_addr) {
+            NewConnectionInLoop(raw_shard, connfd, peer_addr);
+        });
+        // NOTE: 依次在各自的 loop 线程中 Listen 并等待完成:
+        // SO_REUSEPORT 组内 socket 的顺序与 Subloop 的顺序一致, cBPF 按下标选择时才能对应到正确的 Subloop
+        std::promise<void> listened;
+        shard->loop->RunInLoop(
+            [raw_shard, &listened] {
+                raw_shard->acceptor->Listen();
+                listened.set_value();
+            },
+            EventLoop::Priority::kControl);
+        listened.get_future().wait();
+    }
+    if (cpu_steering_ &&
+        !shards_.front()->acceptor->AttachReusePortCpuFilter(static_cast<int>(shards_.size()))) {
+        LOG_ERROR("TcpServer::Start [%s] - SO_ATTACH_REUSEPORT_CBPF error:%d\n", name_.c_str(), errno);
+    }
+}
+
+void TcpServer::ConfigureAcceptor(Acceptor* acceptor) {
+    acceptor->SetAcceptBatch(accept_batch_);
+    acceptor->SetCounters(acceptor_counters_);
+    if (max_connections_ > 0 || rate_limiter_) {
+        acceptor->SetAdmissionCallback([this] { return CheckAdmission(); }, overload_action_);
+    }
+}
+
+std::chrono::nanoseconds TcpServer::CheckAdmission() const {
+    if (max_connections_ > 0 && num_connections_.load(std::memory_order_relaxed) >= max_connections_) {
+        return kMaxConnectionsRetryDelay;
+    }
+    return rate_limiter_ ? rate_limiter_->Delay() : std::chrono::nanoseconds{0};
+}
+
+void TcpServer::AdmitConnection(EventLoop* io_loop) {
+    // NOTE: 分配 loop 时就计入连接数, DispatchPolicy 连续分配多个连接时能立即看到
+    io_loop->AddConnection();
+    num_connections_.fetch_add(1, std::memory_order_relaxed);
+    if (rate_limiter_) {
+        rate_limiter_->Consume();
+    }
+}
+
+TcpServer::ConnectionShard* TcpServer::ShardOf(EventLoop* io_loop) const {
+    // NOTE: loop 数量很少, 线性查找即可; shards_ 在 Start 之后只读, 任何线程都可以查找
+    for (auto& shard : shards_) {
+        if (shard->loop == io_loop) {
+            return shard.get();
+        }
+    }
+    LOG_FATAL("TcpServer [%s] - no connection shard for loop %p\n", name_.c_str(), io_loop);
+    return nullptr;
+}
+
 void TcpServer::NewConnection(int connfd, InetAddress const& peer_addr) {
-    // 轮询选择一个 Subloop 管理新连接
-    auto sub_loop{thread_pool_->GetNextLoop()};  // 获取管理新连接的 Subloop
-    char buf[64]{};
-    snprintf(buf, sizeof(buf), "-%s#%d", ip_port_.c_str(), next_conn_id_++);  // 新连接的名称
-    auto conn_name{name_ + buf};
-    LOG_INFO("TcpServer::NewConnection [%s] - new connection [%s] from %s\n", name_.c_str(), conn_name.c_str(),
-             peer_addr.ToIpPort().c_str());
-    sockaddr_in local{};
+    // 按分配策略(默认轮询)选择一个 Subloop 管理新连接
+    auto sub_loop{thread_pool_->GetLoopFor(peer_addr)};  // 获取管理新连接的 Subloop
+    auto shard{ShardOf(sub_loop)};
+    AdmitConnection(sub_loop);
+
+    // HACK: 对照 RemoveConnectionInLoop 中 QueueInLoop 理解
+    // 在 sub_loop 中建立连接需要调用 conn->ConnectEstablished()
+    // 在 sub_loop 中销毁连接需要调用 conn->ConnectDestroyed()
+    // NOTE: TcpConnection 也在 sub_loop 中构造: 连接的内存从 sub_loop 线程的 block_pool 分配,
+    // 销毁时归还到同一个池, 构造的开销也不再落在 Mainloop 上
+    // NOTE: 建立/销毁连接属于控制类任务, 不会被大量 Send 任务拖延
+    sub_loop->RunInLoop(
+        [this, alive = std::weak_ptr(alive_), sub_loop, shard, connfd, peer_addr] {
+            if (alive.expired()) {
+                sub_loop->RemoveConnection();  // TcpServer 正在析构: 丢弃这个连接
+                close(connfd);
+                return;
+            }
+            NewConnectionInShard(shard, connfd, peer_addr);
+        },
+        EventLoop::Priority::kControl);
+}
+
+void TcpServer::NewConnectionInLoop(ConnectionShard* shard, int connfd, InetAddress const& peer_addr) {
+    AdmitConnection(shard->loop);
+    NewConnectionInShard(shard, connfd, peer_addr);
+}
+
+void TcpServer::NewConnectionInShard(ConnectionShard* shard, int connfd, InetAddress const& peer_addr) {
+    RegisterConnectionInLoop(shard, CreateConnection(shard, connfd, peer_addr));
+}
+
+TcpConnectionPtr TcpServer::CreateConnection(ConnectionShard* shard, int connfd, InetAddress const& peer_addr) {
+    uint64_t conn_id = next_conn_id_.fetch_add(1, std::memory_order_relaxed);
+    LOG_INFO("TcpServer::NewConnection [%s] - new connection [%s#%lu] from %s\n", name_.c_str(),
+             conn_name_prefix_->c_str(), conn_id, peer_addr.ToIpPort().c_str());
+    sockaddr_storage local{};
     socklen_t addrlen = sizeof(local);
     if (getsockname(connfd, reinterpret_cast<sockaddr*>(&local), &addrlen) < 0) {
         LOG_ERROR("getsockname error\n");
     }
-    InetAddress local_addr{local};  // 获取本地地址信息(构造 InetAddress 对象)
+    InetAddress local_addr{reinterpret_cast<sockaddr*>(&local), addrlen};  // 获取本地地址信息(构造 InetAddress 对象)
     // 构造 TcpConnection 对象
-    auto conn_ptr{std::make_shared<TcpConnection>(sub_loop, conn_name, connfd, local_addr, peer_addr)};
-    connections_[conn_name] = conn_ptr;                            // 保存新连接
+    // NOTE: 控制块、TcpConnection(内嵌 Socket/Channel)一次分配, 来自当前 loop 线程的 block_pool
+    auto conn_ptr{std::allocate_shared<TcpConnection>(BlockAllocator<TcpConnection>(), shard->loop, conn_id,
+                                                      conn_name_prefix_, connfd, local_addr, peer_addr)};
     conn_ptr->SetConnectionCallback(connection_callback_);         // 设置连接建立后的回调函数
     conn_ptr->SetMessageCallback(message_callback_);               // 设置收到消息后的回调函数
     conn_ptr->SetWriteCompleteCallback(write_complete_callback_);  // 设置发送完消息后的回调函数
 
-    // NOTE: 这里连接关闭回调函数是 TcpServer::RemoveConnection, 没让用户自定义
-    // HACK: 按值捕获 conn
+    // NOTE: 这里连接关闭回调函数是 TcpServer::RemoveConnectionInLoop, 没让用户自定义
+    // 关闭回调在连接所属的 loop 线程中执行, 直接操作该 loop 的连接表
     conn_ptr->SetCloseCallback(
-        [this, conn_ptr](TcpConnectionPtr const&) { RemoveConnection(conn_ptr); });  // 设置连接关闭后的回调函数
+        [this, shard](TcpConnectionPtr const& conn) { RemoveConnectionInLoop(shard, conn); });  // 设置连接关闭后的回调函数
+    return conn_ptr;
+}
 
-    // HACK: 对照 RemoveConnectionInLoop 中 sub_loop->QueueInLoop  理解
-    // 在 sub_loop 中建立连接需要调用 conn->ConnectEstablished()
-    // 在 sub_loop 中销毁连接需要调用 conn->ConnectDestroyed()
-    // HACK: 按值捕获 conn
-    sub_loop->RunInLoop([conn_ptr] { conn_ptr->ConnectEstablished(); });
+void TcpServer::RegisterConnectionInLoop(ConnectionShard* shard, TcpConnectionPtr const& conn_ptr) {
+    shard->connections.emplace(conn_ptr->id(), conn_ptr);  // 保存新连接
+    conn_ptr->ConnectEstablished();
+    if (shard->stopping) {
+        conn_ptr->DrainAndClose();  // Stop 之后才登记的连接
+    }
+}
+
+void TcpServer::RemoveConnectionInLoop(ConnectionShard* shard, TcpConnectionPtr const& conn_ptr) {
+    LOG_INFO("TcpServer::RemoveConnectionInLoop [%s] - connection %s#%lu\n", name_.c_str(),
+             conn_name_prefix_->c_str(), conn_ptr->id());
+    shard->connections.erase(conn_ptr->id());
+    shard->loop->RemoveConnection();
+    num_connections_.fetch_sub(1, std::memory_order_relaxed);
+    // NOTE: 正处于该连接 Channel 的回调中, 销毁(从 Poller 中移除 Channel)放到任务中执行;
+    // 同一个 loop 内入队, 不需要唤醒
+    // NOTE: 任务只持有连接本身, 不访问 TcpServer(TcpServer 析构之后仍可能执行)
+    shard->loop->QueueInLoop([conn_ptr] { conn_ptr->ConnectDestroyed(); }, EventLoop::Priority::kControl);
+    TryFinishShardStop(shard);
 }
 
-void TcpServer::RemoveConnection(TcpConnectionPtr const& conn_ptr) {
-    // 所有 TcpConnectionPtr 由 Mainloop 管理, 所以这里通过 Mainloop 删除连接
-    loop_->RunInLoop([this, conn_ptr] { RemoveConnectionInLoop(conn_ptr); });
+void TcpServer::Stop(std::chrono::milliseconds timeout, StopCallback cb) {
+    loop_->RunInLoop(
+        [this, alive = std::weak_ptr(alive_), timeout, cb = std::move(cb)]() mutable {
+            if (!alive.expired()) {
+                StopInLoop(timeout, std::move(cb));
+            }
+        },
+        EventLoop::Priority::kControl);
 }
 
-void TcpServer::RemoveConnectionInLoop(TcpConnectionPtr const& conn_ptr) {
-    LOG_INFO("TcpServer::RemoveConnectionInLoop [%s] - connection %s\n", name_.c_str(), conn_ptr->GetName().c_str());
-    connections_.erase(conn_ptr->GetName());
-    // HACK: 先获取当前连接的 Subloop
-    auto sub_loop{conn_ptr->GetLoop()};
-    // 再将 TcpConnection 的连接销毁函数放入 Subloop 的任务队列
-    sub_loop->QueueInLoop([conn_ptr] { conn_ptr->ConnectDestroyed(); });
+std::future<bool> TcpServer::Stop(std::chrono::milliseconds timeout) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    auto future = promise->get_future();
+    Stop(timeout, [promise](bool drained) { promise->set_value(drained); });
+    return future;
+}
+
+void TcpServer::StopInLoop(std::chrono::milliseconds timeout, StopCallback cb) {
+    if (stopping_) {
+        LOG_ERROR("TcpServer::Stop [%s] - already stopping\n", name_.c_str());
+        return;
+    }
+    stopping_ = true;
+    stop_callback_ = std::move(cb);
+    if (acceptor_) {
+        acceptor_->Stop();  // 1. 不再接受新连接
+    }
+    LOG_INFO("TcpServer::Stop [%s] - draining connections on %zu loops\n", name_.c_str(), shards_.size());
+    // 2. 每个 shard 在自己的 loop 中停止 Acceptor 并优雅关闭所有连接, 全部销毁后回到 Mainloop 计数
+    // NOTE: 同一 lane 内 FIFO, Mainloop 此前投递的连接登记一定先于停止任务执行
+    shards_stopping_ = shards_.size();
+    for (auto& shard : shards_) {
+        auto raw_shard = shard.get();
+        raw_shard->loop->RunInLoop(
+            [this, alive = std::weak_ptr(alive_), raw_shard] {
+                if (!alive.expired()) {
+                    StopShardInLoop(raw_shard);
+                }
+            },
+            EventLoop::Priority::kControl);
+    }
+    // 3. 超时后强制关闭剩下的连接
+    stop_timer_ = loop_->RunAfter(timeout, [this, alive = std::weak_ptr(alive_)] {
+        if (alive.expired()) {
+            return;
+        }
+        stop_timer_ = TimerId{};
+        LOG_WARNING("TcpServer::Stop [%s] - timeout, force closing remaining connections\n", name_.c_str());
+        drained_ = false;
+        for (auto& shard : shards_) {
+            auto raw_shard = shard.get();
+            raw_shard->loop->RunInLoop(
+                [alive = std::weak_ptr(alive_), raw_shard] {
+                    if (alive.expired()) {
+                        return;  // 析构函数已经(或将要)销毁这些连接
+                    }
+                    for (auto& conn_ptr : SnapshotConnections(raw_shard)) {
+                        conn_ptr->ForceClose();
+                    }
+                },
+                EventLoop::Priority::kControl);
+        }
+    });
+    TryFinishStop();
+}
+
+void TcpServer::StopShardInLoop(ConnectionShard* shard) {
+    shard->stopping = true;
+    if (shard->acceptor) {
+        shard->acceptor->Stop();
+    }
+    for (auto& conn_ptr : SnapshotConnections(shard)) {
+        conn_ptr->DrainAndClose();
+    }
+    TryFinishShardStop(shard);
+}
+
+std::vector<TcpConnectionPtr> TcpServer::SnapshotConnections(ConnectionShard* shard) {
+    std::vector<TcpConnectionPtr> conns;
+    conns.reserve(shard->connections.size());
+    for (auto& [id, conn_ptr] : shard->connections) {
+        conns.push_back(conn_ptr);
+    }
+    return conns;
+}
+
+void TcpServer::TryFinishShardStop(ConnectionShard* shard) {
+    if (!shard->stopping || !shard->connections.empty() || shard->stopped) {
+        return;
+    }
+    shard->stopped = true;
+    // NOTE: 停止时 shard 要等 ConnectDestroyed 执行完才算停止: 之后 Subloop 随时可能退出, 排队的任务不会再执行
+    // 同一 lane 内 FIFO, 在 shard 的 control lane 末尾入队, 执行时此前排队的 ConnectDestroyed 都已执行完
+    // NOTE: 外层任务在 shard 的 loop 中执行, 不访问 TcpServer
+    shard->loop->QueueInLoop(
+        [this, alive = std::weak_ptr(alive_), main_loop = loop_] {
+            main_loop->RunInLoop(
+                [this, alive] {
+                    if (alive.expired()) {
+                        return;
+                    }
+                    --shards_stopping_;
+                    TryFinishStop();
+                },
+                EventLoop::Priority::kControl);
+        },
+        EventLoop::Priority::kControl);
+}
+
+void TcpServer::TryFinishStop() {
+    if (!stopping_ || shards_stopping_ > 0 || stopped_) {
+        return;
+    }
+    stopped_ = true;
+    loop_->CancelTimer(stop_timer_);
+    stop_timer_ = TimerId{};
+    // 4. 退出所有 Subloop
+    // NOTE: 每个 shard 在最后一个 ConnectDestroyed 执行完之后才报告停止, 此时 Subloop 上已经没有要销毁的连接
+    std::vector<EventLoop*> sub_loops;
+    if (thread_pool_->started() && num_threads_ > 0) {
+        sub_loops = thread_pool_->GetAllLoops();
+    }
+    auto remaining = std::make_shared<std::atomic<size_t>>(sub_loops.size());
+    auto done = [this, alive = std::weak_ptr(alive_)] {
+        if (alive.expired()) {
+            return;
+        }
+        LOG_INFO("TcpServer::Stop [%s] - stopped, drained=%d\n", name_.c_str(), drained_);
+        // NOTE: 用户可能在回调中析构 TcpServer, 先取出回调
+        auto cb = std::move(stop_callback_);
+        if (cb) {
+            cb(drained_);
+        }
+    };
+    if (sub_loops.empty()) {
+        done();
+        return;
+    }
+    // NOTE: 退出任务不访问 TcpServer(之后 TcpServer 随时可能析构), 只持有 shard 的 Acceptor
+    // shard 已经停止, 它的 loop 不会再访问 acceptor 这个成员, 可以在 Mainloop 中取走
+    for (size_t i = 0; i < sub_loops.size(); ++i) {
+        auto sub_loop = sub_loops[i];
+        sub_loop->QueueInLoop(
+            [acceptor = std::move(shards_[i]->acceptor), main_loop = loop_, sub_loop, remaining, done]() mutable {
+                acceptor.reset();  // 在所属的 loop 线程中析构
+                sub_loop->Quit();
+                if (remaining->fetch_sub(1) == 1) {
+                    main_loop->QueueInLoop(done);
+                }
+            });
+    }
 }
 
 void TcpServer::SetThreadNum(int num_threads) {
@@ -102,6 +451,62 @@ void TcpServer::SetThreadNum(int num_threads) {
     thread_pool_->SetThreadNum(num_threads);
 }
 
+void TcpServer::SetCpuAffinity(CpuAffinity affinity) {
+    thread_pool_->SetCpuAffinity(std::move(affinity));
+}
+
+void TcpServer::SetReusePortCpuSteering(bool on) {
+    cpu_steering_ = on;
+}
+
+void TcpServer::SetDispatchPolicy(std::unique_ptr<DispatchPolicy> policy) {
+    thread_pool_->SetDispatchPolicy(std::move(policy));
+}
+
+void TcpServer::SetAcceptBatch(int batch) {
+    accept_batch_ = batch;
+}
+
+void TcpServer::AdoptListenSockets(std::vector<int> fds) {
+    adopted_fds_ = std::move(fds);
+}
+
+std::vector<int> TcpServer::listen_fds() const {
+    std::vector<int> fds;
+    if (acceptor_) {
+        fds.push_back(acceptor_->listen_fd());
+    }
+    for (auto& shard : shards_) {
+        if (shard->acceptor) {
+            fds.push_back(shard->acceptor->listen_fd());
+        }
+    }
+    return fds;
+}
+
+void TcpServer::MarkListenSocketsHandedOff() {
+    if (acceptor_) {
+        acceptor_->SetHandedOff();
+    }
+    for (auto& shard : shards_) {
+        if (shard->acceptor) {
+            shard->acceptor->SetHandedOff();
+        }
+    }
+}
+
+void TcpServer::SetConnectionRateLimit(double rate, double burst) {
+    rate_limiter_ = rate > 0 ? std::make_unique<TokenBucket>(rate, burst) : nullptr;
+}
+
+void TcpServer::SetMaxConnections(size_t max_connections) {
+    max_connections_ = max_connections;
+}
+
+void TcpServer::SetOverloadAction(Acceptor::OverloadAction action) {
+    overload_action_ = action;
+}
+
 void TcpServer::SetThreadInitCallback(ThreadInitCallback cb) {
     thread_init_callback_ = std::move(cb);
 }
@@ -0,0 +1,122 @@
+#include <sys/timerfd.h>
+#include <unistd.h>
+//
+#include <cutemuduo/channel.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/logger.hpp>
+#include <cutemuduo/timer_queue.hpp>
+
+namespace cutemuduo {
+
+static int CreateTimerfd() {
+    int timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd < 0) {
+        LOG_FATAL("timerfd_create error:%d\n", errno);
+    }
+    return timerfd;
+}
+
+TimerQueue::TimerQueue(EventLoop* loop)
+    : loop_(loop),
+      timerfd_(CreateTimerfd()),
+      timer_channel_(std::make_unique<Channel>(loop, timerfd_)),
+      next_seq_(1),
+      armed_(Clock::time_point::max()),
+      running_seq_(0),
+      running_canceled_(false) {
+    timer_channel_->SetReadCallback([this](Timestamp) { HandleRead(); });
+    timer_channel_->EnableReading();
+}
+
+TimerQueue::~TimerQueue() {
+    timer_channel_->DisableAll();
+    timer_channel_->Remove();
+    close(timerfd_);
+}
+
+TimerId TimerQueue::AddTimer(TimerCallback cb, Clock::time_point when, Clock::duration interval) {
+    uint64_t seq = next_seq_.fetch_add(1, std::memory_order_relaxed);
+    // NOTE: kControl: 定时器的增删不应被大量普通任务拖延
+    loop_->RunInLoop(
+        [this, seq, cb = std::move(cb), when, interval]() mutable { AddTimerInLoop(seq, std::move(cb), when, interval); },
+        EventLoop::Priority::kControl);
+    return TimerId{seq};
+}
+
+void TimerQueue::Cancel(TimerId id) {
+    if (id.seq == 0) {
+        return;
+    }
+    loop_->RunInLoop([this, seq = id.seq] { CancelInLoop(seq); }, EventLoop::Priority::kControl);
+}
+
+void TimerQueue::AddTimerInLoop(uint64_t seq, TimerCallback cb, Clock::time_point when, Clock::duration interval) {
+    timers_.emplace(Key{when, seq}, Timer{std::move(cb), interval});
+    deadlines_[seq] = when;
+    if (when < armed_) {
+        ResetTimerfd();
+    }
+}
+
+void TimerQueue::CancelInLoop(uint64_t seq) {
+    if (seq == running_seq_) {
+        running_canceled_ = true;  // 回调中取消自身: 执行完后不再重复
+        return;
+    }
+    auto it = deadlines_.find(seq);
+    if (it == deadlines_.end()) {
+        return;
+    }
+    timers_.erase(Key{it->second, seq});
+    deadlines_.erase(it);
+    // NOTE: 不必重新设置 timerfd, 提前醒来时发现没有到期的定时器会再设置一次
+}
+
+void TimerQueue::HandleRead() {
+    uint64_t expirations = 0;
+    ssize_t n = read(timerfd_, &expirations, sizeof(expirations));
+    if (n != sizeof(expirations) && errno != EAGAIN) {
+        LOG_ERROR("TimerQueue::HandleRead() reads %ld bytes instead of 8\n", n);
+    }
+    armed_ = Clock::time_point::max();
+
+    // NOTE: 只处理此刻之前到期的定时器, 回调中新加的(或重复的)定时器留到下一次, 避免死循环
+    Clock::time_point now = Clock::now();
+    while (!timers_.empty() && timers_.begin()->first.first <= now) {
+        auto node = timers_.extract(timers_.begin());
+        uint64_t seq = node.key().second;
+        Timer& timer = node.mapped();
+        running_seq_ = seq;
+        running_canceled_ = false;
+        timer.cb();
+        running_seq_ = 0;
+        if (timer.interval.count() > 0 && !running_canceled_) {
+            node.key().first = now + timer.interval;
+            deadlines_[seq] = node.key().first;
+            timers_.insert(std::move(node));
+        } else {
+            deadlines_.erase(seq);
+        }
+    }
+    ResetTimerfd();
+}
+
+void TimerQueue::ResetTimerfd() {
+    struct itimerspec spec = {};  // 全 0: 停止
+    if (!timers_.empty()) {
+        armed_ = timers_.begin()->first.first;
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(armed_.time_since_epoch()).count();
+        if (ns <= 0) {
+            ns = 1;  // it_value 为 0 表示停止, 已经到期的定时器设为 1ns(立即触发)
+        }
+        spec.it_value.tv_sec = ns / 1000000000;
+        spec.it_value.tv_nsec = ns % 1000000000;
+    } else {
+        armed_ = Clock::time_point::max();
+    }
+    if (timerfd_settime(timerfd_, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+        LOG_ERROR("timerfd_settime error:%d\n", errno);
+    }
+}
+
+}  // namespace cutemuduo
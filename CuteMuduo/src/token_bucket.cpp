@@ -0,0 +1,30 @@
+#include <algorithm>
+//
+#include <cutemuduo/token_bucket.hpp>
+
+namespace cutemuduo {
+
+TokenBucket::TokenBucket(double rate, double burst)
+    : interval_ns_(std::max<int64_t>(static_cast<int64_t>(1e9 / rate), 1)),
+      tolerance_ns_(static_cast<int64_t>((std::max(burst, 1.0) - 1) * static_cast<double>(interval_ns_))),
+      tat_ns_(NowNs()) {}
+
+int64_t TokenBucket::NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+std::chrono::nanoseconds TokenBucket::Delay() const {
+    int64_t wait = tat_ns_.load(std::memory_order_relaxed) - tolerance_ns_ - NowNs();
+    return std::chrono::nanoseconds(std::max<int64_t>(wait, 0));
+}
+
+void TokenBucket::Consume() {
+    int64_t now = NowNs();
+    int64_t tat = tat_ns_.load(std::memory_order_relaxed);
+    // NOTE: 空闲期间 tat_ 落后于当前时间, 从当前时间开始算(空闲不会积攒超过 burst 个令牌)
+    while (!tat_ns_.compare_exchange_weak(tat, std::max(tat, now) + interval_ns_, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace cutemuduo
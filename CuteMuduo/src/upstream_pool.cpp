@@ -0,0 +1,195 @@
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/logger.hpp>
+#include <cutemuduo/tcp_client.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+#include <cutemuduo/upstream_pool.hpp>
+
+namespace cutemuduo {
+
+UpstreamPool::UpstreamPool(EventLoop* loop, InetAddress const& upstream, std::string const& name,
+                           ResponseFramer framer, Options options)
+    : loop_(loop), name_(name), framer_(std::move(framer)), options_(std::move(options)), closing_(false) {
+    for (size_t i = 0; i < options_.connections; ++i) {
+        auto slot = std::make_unique<Slot>();
+        auto raw_slot = slot.get();
+        slot->client = std::make_unique<TcpClient>(loop, upstream, name + "#" + std::to_string(i));
+        slot->client->SetConnectionCallback(
+            [this, raw_slot](TcpConnectionPtr const& conn_ptr) { OnConnection(raw_slot, conn_ptr); });
+        slot->client->SetMessageCallback(
+            [this, raw_slot](TcpConnectionPtr const&, Buffer* buf, Timestamp) { OnMessage(raw_slot, buf); });
+        slot->client->SetAutoReconnect(true);
+        slot->client->SetRetryDelay(options_.initial_retry_delay, options_.max_retry_delay);
+        slots_.push_back(std::move(slot));
+    }
+}
+
+UpstreamPool::~UpstreamPool() {
+    loop_->CancelTimer(health_timer_);
+    closing_ = true;
+    for (auto& slot : slots_) {
+        FailPending(slot.get());
+    }
+    for (auto& waiting : waiting_) {
+        Fail(waiting.cb);
+    }
+    // NOTE: TcpClient 析构时强制关闭连接, 期间的连接断开回调看到 closing_ 直接返回
+    slots_.clear();
+}
+
+void UpstreamPool::Start() {
+    for (auto& slot : slots_) {
+        slot->client->Connect();
+    }
+    health_timer_ = loop_->RunEvery(options_.health_check_interval, [this] { HealthCheck(); });
+}
+
+void UpstreamPool::Request(std::string_view request, ResponseCallback cb) {
+    if (closing_) {
+        Fail(cb);  // 析构时失败回调中又发出的请求
+    } else if (Slot* slot = PickSlot()) {
+        SendOnSlot(slot, request, std::move(cb));
+    } else if (waiting_.size() < options_.max_waiting) {
+        waiting_.push_back(
+            WaitingRequest{std::string(request), std::move(cb), Clock::now() + options_.request_timeout});
+    } else {
+        Fail(cb);
+    }
+}
+
+size_t UpstreamPool::connected() const {
+    size_t n = 0;
+    for (auto& slot : slots_) {
+        n += slot->conn != nullptr;
+    }
+    return n;
+}
+
+size_t UpstreamPool::pending() const {
+    size_t n = waiting_.size();
+    for (auto& slot : slots_) {
+        n += slot->pending.size();
+    }
+    return n;
+}
+
+void UpstreamPool::OnConnection(Slot* slot, TcpConnectionPtr const& conn_ptr) {
+    if (closing_) {
+        return;
+    }
+    if (conn_ptr->IsConnected()) {
+        LOG_INFO("UpstreamPool [%s] - %s connected\n", name_.c_str(), conn_ptr->GetName().c_str());
+        conn_ptr->SetTcpNoDelay(true);
+        slot->conn = conn_ptr;
+        slot->last_active = Clock::now();
+        FlushWaiting();
+    } else {
+        LOG_WARNING("UpstreamPool [%s] - %s disconnected, %zu requests failed\n", name_.c_str(),
+                    conn_ptr->GetName().c_str(), slot->pending.size());
+        slot->conn.reset();
+        FailPending(slot);
+    }
+}
+
+void UpstreamPool::OnMessage(Slot* slot, Buffer* buf) {
+    // NOTE: 回调中可能关闭这个连接(Evict)或发送新请求, 每次循环都重新检查
+    while (slot->conn && buf->ReadableBytes() > 0) {
+        ssize_t n = framer_(buf);
+        if (n == 0) {
+            break;
+        }
+        if (n < 0 || static_cast<size_t>(n) > buf->ReadableBytes() || slot->pending.empty()) {
+            buf->RetrieveAll();
+            Evict(slot, n < 0 ? "malformed response" : "unexpected response");
+            break;
+        }
+        ResponseCallback cb = std::move(slot->pending.front().cb);
+        slot->pending.pop_front();
+        slot->last_active = Clock::now();
+        if (cb) {
+            ++stats_.completed;
+            cb(true, std::string_view(buf->Peek(), static_cast<size_t>(n)));
+        }
+        buf->Retrieve(static_cast<size_t>(n));
+    }
+    if (!waiting_.empty()) {
+        FlushWaiting();
+    }
+}
+
+UpstreamPool::Slot* UpstreamPool::PickSlot() {
+    Slot* best = nullptr;
+    for (auto& slot : slots_) {
+        if (slot->conn && slot->pending.size() < options_.max_pending_per_connection &&
+            (best == nullptr || slot->pending.size() < best->pending.size())) {
+            best = slot.get();
+        }
+    }
+    return best;
+}
+
+void UpstreamPool::SendOnSlot(Slot* slot, std::string_view request, ResponseCallback cb) {
+    auto now = Clock::now();
+    slot->pending.push_back(PendingRequest{std::move(cb), now + options_.request_timeout});
+    slot->last_active = now;
+    slot->conn->SendInLoop(request.data(), request.size());
+}
+
+void UpstreamPool::FlushWaiting() {
+    while (!waiting_.empty()) {
+        Slot* slot = PickSlot();
+        if (slot == nullptr) {
+            return;
+        }
+        WaitingRequest waiting = std::move(waiting_.front());
+        waiting_.pop_front();
+        SendOnSlot(slot, waiting.request, std::move(waiting.cb));
+    }
+}
+
+void UpstreamPool::Evict(Slot* slot, char const* reason) {
+    LOG_WARNING("UpstreamPool [%s] - evict %s: %s\n", name_.c_str(), slot->conn->GetName().c_str(), reason);
+    ++stats_.evicted;
+    TcpConnectionPtr conn_ptr = std::move(slot->conn);
+    FailPending(slot);
+    conn_ptr->ForceClose();  // 连接断开后 TcpClient 自动重连
+}
+
+void UpstreamPool::FailPending(Slot* slot) {
+    // NOTE: 失败回调中可能发送新请求(可能又落到这个连接上), 先取出再回调
+    std::deque<PendingRequest> pending;
+    pending.swap(slot->pending);
+    for (auto& request : pending) {
+        Fail(request.cb);
+    }
+}
+
+void UpstreamPool::Fail(ResponseCallback& cb) {
+    // NOTE: 探测请求没有回调, 不计入统计
+    if (cb) {
+        ++stats_.failed;
+        cb(false, std::string_view());
+    }
+}
+
+void UpstreamPool::HealthCheck() {
+    auto now = Clock::now();
+    for (auto& slot : slots_) {
+        if (!slot->conn) {
+            continue;
+        }
+        if (!slot->pending.empty() && slot->pending.front().deadline <= now) {
+            Evict(slot.get(), "request timeout");
+        } else if (slot->pending.empty() && !options_.probe_request.empty() &&
+                   now - slot->last_active >= options_.health_check_interval) {
+            SendOnSlot(slot.get(), options_.probe_request, nullptr);  // 探测请求: 响应直接丢弃
+        }
+    }
+    while (!waiting_.empty() && waiting_.front().deadline <= now) {
+        ResponseCallback cb = std::move(waiting_.front().cb);
+        waiting_.pop_front();
+        Fail(cb);
+    }
+}
+
+}  // namespace cutemuduo
@@ -0,0 +1,133 @@
+#include <algorithm>
+//
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/logger.hpp>
+#include <cutemuduo/watchdog.hpp>
+
+namespace cutemuduo {
+
+char const* CallbackPhaseToString(CallbackPhase phase) {
+    switch (phase) {
+        case CallbackPhase::kIdle:
+            return "idle";
+        case CallbackPhase::kChannel:
+            return "channel";
+        case CallbackPhase::kFunctor:
+            return "functor";
+    }
+    return "unknown";
+}
+
+Watchdog::Watchdog(std::chrono::milliseconds threshold)
+    : threshold_(std::max(threshold, std::chrono::milliseconds{1})),
+      slow_callbacks_(0),
+      running_(false),
+      thread_([this] { Run(); }, "Watchdog") {}
+
+Watchdog::~Watchdog() {
+    Stop();
+}
+
+void Watchdog::Watch(EventLoop* loop) {
+    auto slot = std::make_shared<WatchdogSlot>();
+    if (!loop->AttachWatchdog(slot)) {
+        LOG_ERROR("Watchdog::Watch loop %p is already watched\n", loop);
+        return;
+    }
+    std::unique_lock lk{mtx_};
+    slots_.push_back(std::move(slot));
+}
+
+void Watchdog::SetSlowCallbackHandler(SlowCallbackHandler handler) {
+    handler_ = std::move(handler);
+}
+
+void Watchdog::Start() {
+    {
+        std::unique_lock lk{mtx_};
+        if (running_) {
+            return;
+        }
+        running_ = true;
+    }
+    thread_.Start();
+}
+
+void Watchdog::Stop() {
+    {
+        std::unique_lock lk{mtx_};
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_one();
+    thread_.Join();
+}
+
+uint64_t Watchdog::slow_callbacks() const {
+    return slow_callbacks_.load(std::memory_order_relaxed);
+}
+
+void Watchdog::Run() {
+    // NOTE: 以阈值的 1/4 为周期扫描, 慢回调最迟在 1.25 * threshold 时被发现
+    auto interval = std::max(threshold_ / 4, std::chrono::milliseconds{1});
+    std::unique_lock lk{mtx_};
+    while (running_) {
+        cv_.wait_for(lk, interval, [this] { return !running_; });
+        if (!running_) {
+            break;
+        }
+        auto reports = Scan();
+        if (reports.empty()) {
+            continue;
+        }
+        lk.unlock();
+        for (auto& info : reports) {
+            Report(info);
+        }
+        lk.lock();
+    }
+}
+
+std::vector<Watchdog::SlowCallbackInfo> Watchdog::Scan() {
+    std::vector<SlowCallbackInfo> reports;
+    int64_t now = WatchdogNowNs();
+    int64_t threshold_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(threshold_).count();
+    for (auto it = slots_.begin(); it != slots_.end();) {
+        WatchdogSlot& slot = **it;
+        if (!slot.attached.load(std::memory_order_acquire)) {
+            it = slots_.erase(it);  // loop 已析构
+            continue;
+        }
+        ++it;
+        int64_t start = slot.start_ns.load(std::memory_order_acquire);
+        if (start == 0 || now - start < threshold_ns || slot.flagged_start.load(std::memory_order_relaxed) == start) {
+            continue;
+        }
+        int fd = slot.fd.load(std::memory_order_relaxed);
+        CallbackPhase phase = slot.phase.load(std::memory_order_relaxed);
+        // NOTE: 读取 fd/phase 期间回调可能已经结束并开始下一个, start_ns 变化说明读到的不一致, 下次再看
+        if (slot.start_ns.load(std::memory_order_acquire) != start) {
+            continue;
+        }
+        slot.flagged_start.store(start, std::memory_order_relaxed);
+        slow_callbacks_.fetch_add(1, std::memory_order_relaxed);
+
+        reports.push_back({slot.loop, slot.tid, phase, fd,
+                           std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::nanoseconds{now - start})});
+    }
+    return reports;
+}
+
+void Watchdog::Report(SlowCallbackInfo const& info) {
+    if (handler_) {
+        handler_(info);
+        return;
+    }
+    LOG_WARNING("Watchdog: slow callback on loop %p (tid %d): phase=%s fd=%d running for %ld ms (threshold %ld ms)\n",
+                info.loop, info.tid, CallbackPhaseToString(info.phase), info.fd,
+                static_cast<long>(info.elapsed.count()), static_cast<long>(threshold_.count()));
+}
+
+}  // namespace cutemuduo
@@ -0,0 +1,74 @@
+// CPU 绑定对比: 同样的多线程 echo 负载, Subloop 线程不绑定 / 每个物理核一个线程
+// 用法: affinity_bench [Subloop 线程数=物理核数] [连接数=1000] [每组秒数=3] [消息字节数=64]
+
+#include <stdlib.h>
+
+#include <thread>
+//
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/cpu_affinity.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/event_loop_thread_pool.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+#include <cutemuduo/tcp_server.hpp>
+//
+#include "bench_util.hpp"
+
+using namespace cutemuduo;
+
+static bench::EchoResult RunCase(CpuAffinity const& affinity, uint16_t port, int threads, int conns, size_t msg_size,
+                                 std::chrono::milliseconds duration) {
+    bench::EchoResult result;
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port), "AffinityBench");
+    server.SetThreadNum(threads);
+    server.SetCpuAffinity(affinity);
+    server.SetConnectionCallback([](TcpConnectionPtr const&) {});
+    server.SetMessageCallback([](TcpConnectionPtr const& conn, Buffer* buf, Timestamp) { conn->Send(buf); });
+    server.Start();
+
+    std::thread client([&] {
+        result = bench::RunEchoClient(port, conns, msg_size, duration);
+        loop.Quit();
+    });
+    loop.Loop();
+    client.join();
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> cores = cpu_affinity::PhysicalCoreCpus();
+    int threads = argc > 1 ? atoi(argv[1]) : static_cast<int>(cores.size());
+    int conns = argc > 2 ? atoi(argv[2]) : 1000;
+    auto duration = std::chrono::milliseconds(static_cast<int>((argc > 3 ? atof(argv[3]) : 3.0) * 1000));
+    size_t msg_size = argc > 4 ? static_cast<size_t>(atoi(argv[4])) : 64;
+
+    bench::SilenceLogger();
+    bench::RaiseFdLimit();
+
+    printf("physical cores: %zu, sub loops: %d, conns: %d, msg: %zu bytes\n", cores.size(), threads, conns, msg_size);
+    printf("%-22s %12s %10s %10s %8s\n", "affinity", "msgs/s", "p50(us)", "p99(us)", "errors");
+    struct Case {
+        char const* name;
+        CpuAffinity affinity;
+    } const cases[] = {
+        {"none", CpuAffinity::None()},
+        {"one-per-physical-core", CpuAffinity::OnePerPhysicalCore()},
+    };
+    uint16_t port = 19200;
+    double base = 0;
+    for (auto const& c : cases) {
+        auto r = RunCase(c.affinity, ++port, threads, conns, msg_size, duration);
+        double rate = static_cast<double>(r.messages) / r.seconds;
+        printf("%-22s %12.0f %10.1f %10.1f %8lu", c.name, rate, r.p50_us, r.p99_us, r.errors);
+        if (base > 0) {
+            printf("  (%+.1f%%)", (rate / base - 1) * 100);
+        } else {
+            base = rate;
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+    return 0;
+}
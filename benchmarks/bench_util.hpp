@@ -0,0 +1,228 @@
+#pragma once
+
+// benchmarks 共用的小工具: 计时/分位数/fd 上限/基于 raw epoll 的 echo 客户端/每个 loop 一个 Worker 的客户端脚手架
+// NOTE: echo 客户端刻意不使用 cutemuduo, 保证对比不同后端时客户端开销一致
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// 关闭 cutemuduo 的日志输出(Logger 写 std::cout, 结果统一用 printf 输出)
+inline void SilenceLogger() {
+    std::cout.setstate(std::ios::failbit);
+}
+
+// 尽量提高 RLIMIT_NOFILE, 返回最终的软上限
+inline long RaiseFdLimit() {
+    rlimit rl{};
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        getrlimit(RLIMIT_NOFILE, &rl);
+        return static_cast<long>(rl.rlim_cur);
+    }
+    return 1024;
+}
+
+// 第 p (0~100) 百分位, 会打乱 samples 的顺序
+inline double Percentile(std::vector<int64_t>& samples, double p) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    size_t k = static_cast<size_t>(p / 100.0 * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+    return static_cast<double>(samples[k]);
+}
+
+// =================== 每个 loop 线程一个 Worker 的客户端(pingpong_client / load_generator) ===================
+// Worker 需提供 loop()(所属 EventLoop) 和 connected()(已建立的连接数, 任何线程都可以读)
+
+// 在每个 Worker 的 loop 线程中执行 fn(worker) 并等待全部完成
+template <typename Worker, typename Fn>
+void RunAll(std::vector<std::unique_ptr<Worker>>& workers, Fn fn) {
+    std::vector<std::future<void>> done;
+    for (auto& worker : workers) {
+        auto promise = std::make_shared<std::promise<void>>();
+        done.push_back(promise->get_future());
+        worker->loop()->RunInLoop([raw = worker.get(), fn, promise] {
+            fn(raw);
+            promise->set_value();
+        });
+    }
+    for (auto& f : done) {
+        f.wait();
+    }
+}
+
+// 等待所有 Worker 上共 expected 个连接建立, 超时返回已经建立的连接数
+template <typename Worker>
+int WaitConnected(std::vector<std::unique_ptr<Worker>> const& workers, int expected, std::chrono::seconds timeout) {
+    auto deadline = Clock::now() + timeout;
+    int connected = 0;
+    while (Clock::now() < deadline) {
+        connected = 0;
+        for (auto& worker : workers) {
+            connected += worker->connected();
+        }
+        if (connected == expected) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return connected;
+}
+
+struct EchoResult {
+    int connected = 0;        // 成功建立的连接数
+    uint64_t messages = 0;    // 完成的往返次数
+    double seconds = 0;       // 压测阶段耗时
+    double p50_us = 0;        // 往返延迟 p50
+    double p99_us = 0;        // 往返延迟 p99
+    uint64_t errors = 0;      // 连接失败/异常断开
+};
+
+// 打开 conns 个连接, 每个连接 ping-pong 一个 msg_size 字节的消息, 持续 duration
+// NOTE: 源地址在 127.0.0.x 上轮换并使用 IP_BIND_ADDRESS_NO_PORT, 突破单个源地址的临时端口数限制
+inline EchoResult RunEchoClient(uint16_t port, int conns, size_t msg_size, std::chrono::milliseconds duration) {
+    struct Conn {
+        int fd = -1;
+        bool connected = false;
+        size_t received = 0;
+        int64_t sent_at = 0;
+    };
+
+    EchoResult result;
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<Conn> cs(conns);
+    std::vector<epoll_event> events(1024);
+    std::string msg(msg_size, 'x');
+    std::vector<char> buf(std::max<size_t>(msg_size, 65536));
+    std::vector<int64_t> latencies;
+    latencies.reserve(1 << 20);
+
+    sockaddr_in server{};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // 1. 建立连接(最多 kMaxInflight 个同时进行, 避免 listen backlog 溢出导致 SYN 重传)
+    constexpr int kMaxInflight = 512;
+    int next = 0, inflight = 0, done = 0;
+    auto deadline = Clock::now() + std::chrono::seconds(30);
+    while (done < conns && Clock::now() < deadline) {
+        while (next < conns && inflight < kMaxInflight) {
+            Conn& c = cs[next];
+            c.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            int one = 1;
+            setsockopt(c.fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+            setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            sockaddr_in local{};
+            local.sin_family = AF_INET;
+            local.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + next % 16);
+            bind(c.fd, reinterpret_cast<sockaddr*>(&local), sizeof(local));
+            connect(c.fd, reinterpret_cast<sockaddr*>(&server), sizeof(server));
+            epoll_event ev{};
+            ev.events = EPOLLOUT;
+            ev.data.u32 = static_cast<uint32_t>(next);
+            epoll_ctl(epfd, EPOLL_CTL_ADD, c.fd, &ev);
+            ++next;
+            ++inflight;
+        }
+        int n = epoll_wait(epfd, events.data(), static_cast<int>(events.size()), 100);
+        for (int i = 0; i < n; ++i) {
+            Conn& c = cs[events[i].data.u32];
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            epoll_event ev{};
+            ev.data.u32 = events[i].data.u32;
+            if (err == 0) {
+                c.connected = true;
+                ++result.connected;
+                ev.events = EPOLLIN;
+                epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &ev);
+            } else {
+                ++result.errors;
+                epoll_ctl(epfd, EPOLL_CTL_DEL, c.fd, &ev);
+            }
+            --inflight;
+            ++done;
+        }
+    }
+
+    // 2. ping-pong
+    int64_t start = NowNs();
+    int64_t end = start + std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    for (auto& c : cs) {
+        if (c.connected) {
+            c.sent_at = NowNs();
+            if (write(c.fd, msg.data(), msg.size()) != static_cast<ssize_t>(msg.size())) {
+                ++result.errors;
+            }
+        }
+    }
+    int64_t now = start;
+    while (now < end) {
+        int n = epoll_wait(epfd, events.data(), static_cast<int>(events.size()), 100);
+        now = NowNs();
+        for (int i = 0; i < n; ++i) {
+            Conn& c = cs[events[i].data.u32];
+            ssize_t r = read(c.fd, buf.data(), buf.size());
+            if (r <= 0) {
+                ++result.errors;
+                epoll_ctl(epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+                c.connected = false;
+                continue;
+            }
+            c.received += static_cast<size_t>(r);
+            while (c.received >= msg_size) {
+                c.received -= msg_size;
+                latencies.push_back(now - c.sent_at);
+                ++result.messages;
+            }
+            if (c.received == 0 && now < end) {
+                c.sent_at = now;
+                if (write(c.fd, msg.data(), msg.size()) != static_cast<ssize_t>(msg.size())) {
+                    ++result.errors;
+                }
+            }
+        }
+    }
+    result.seconds = static_cast<double>(NowNs() - start) / 1e9;
+    result.p50_us = Percentile(latencies, 50) / 1e3;
+    result.p99_us = Percentile(latencies, 99) / 1e3;
+
+    for (auto& c : cs) {
+        if (c.fd >= 0) {
+            close(c.fd);
+        }
+    }
+    close(epfd);
+    return result;
+}
+
+}  // namespace bench
@@ -0,0 +1,132 @@
+// Channel 事件分发基准: Tie + 4 个 std::function 回调 vs ChannelHandler(一次虚函数调用, 不 Tie)
+// 用法: channel_dispatch_bench [Channel 数=64] [每种方式的事件数=20000000]
+//
+// 1. dispatch: 直接对 Channel 调用 HandleEvent(revents=EPOLLIN), 只有分发本身的开销
+// 2. loop: N 个一直可读的 eventfd(水平触发, 不读走)注册到同一个 EventLoop, 每轮 Poll 返回 N 个事件,
+//    统计单个 loop 线程每秒处理的事件数(包括 epoll_wait 的开销)
+
+#include <stdlib.h>
+#include <sys/eventfd.h>
+
+#include <memory>
+#include <vector>
+//
+#include <cutemuduo/channel.hpp>
+#include <cutemuduo/event_loop.hpp>
+//
+#include "bench_util.hpp"
+
+using namespace cutemuduo;
+
+// 模拟 TcpConnection: 持有 Channel, 事件处理只计数
+class FakeConnection : public std::enable_shared_from_this<FakeConnection>, private ChannelHandler {
+public:
+    FakeConnection(EventLoop* loop, int fd, bool use_handler, uint64_t* events)
+        : channel_(loop, fd), events_(events) {
+        if (use_handler) {
+            channel_.SetHandler(this);
+        } else {
+            channel_.SetReadCallback([this](Timestamp receive_time) { this->HandleRead(receive_time); });
+            channel_.SetWriteCallback([this]() { this->HandleWrite(); });
+            channel_.SetCloseCallback([this]() { this->HandleClose(); });
+            channel_.SetErrorCallback([this]() { this->HandleError(); });
+        }
+    }
+
+    // 原先 TcpConnection 的做法: 每个事件 lock 一次 weak_ptr
+    void Tie() { channel_.Tie(shared_from_this()); }
+
+    Channel* channel() { return &channel_; }
+
+private:
+    void HandleRead(Timestamp) override { ++*events_; }
+
+    void HandleWrite() override {}
+
+    void HandleClose() override {}
+
+    void HandleError() override {}
+
+    Channel channel_;
+    uint64_t* events_;
+};
+
+static std::vector<std::shared_ptr<FakeConnection>> MakeConnections(EventLoop* loop, std::vector<int> const& fds,
+                                                                    bool use_handler, uint64_t* events) {
+    std::vector<std::shared_ptr<FakeConnection>> conns;
+    for (int fd : fds) {
+        conns.push_back(std::make_shared<FakeConnection>(loop, fd, use_handler, events));
+        if (!use_handler) {
+            conns.back()->Tie();
+        }
+    }
+    return conns;
+}
+
+static double RunDispatch(EventLoop* loop, std::vector<int> const& fds, bool use_handler, uint64_t total) {
+    uint64_t events = 0;
+    auto conns = MakeConnections(loop, fds, use_handler, &events);
+    for (auto& conn : conns) {
+        conn->channel()->SetRevents(EPOLLIN);
+    }
+    Timestamp now = Timestamp::Now();
+    int64_t start = bench::NowNs();
+    while (events < total) {
+        for (auto& conn : conns) {
+            conn->channel()->HandleEvent(now);
+        }
+    }
+    return static_cast<double>(events) / (static_cast<double>(bench::NowNs() - start) / 1e9);
+}
+
+static double RunLoop(EventLoop* loop, std::vector<int> const& fds, bool use_handler, uint64_t total) {
+    uint64_t events = 0;
+    auto conns = MakeConnections(loop, fds, use_handler, &events);
+    for (auto& conn : conns) {
+        conn->channel()->EnableReading();
+    }
+    // NOTE: 每轮 loop 的任务阶段检查一次, 处理的事件数达到 total 之后退出
+    std::function<void()> check = [&] {
+        if (events >= total) {
+            loop->Quit();
+        } else {
+            loop->QueueInLoop(check);
+        }
+    };
+    loop->QueueInLoop(check);
+    int64_t start = bench::NowNs();
+    loop->Loop();
+    double rate = static_cast<double>(events) / (static_cast<double>(bench::NowNs() - start) / 1e9);
+    for (auto& conn : conns) {
+        conn->channel()->DisableAll();
+        conn->channel()->Remove();
+    }
+    return rate;
+}
+
+int main(int argc, char* argv[]) {
+    int channels = argc > 1 ? atoi(argv[1]) : 64;
+    uint64_t total = argc > 2 ? strtoull(argv[2], nullptr, 10) : 20000000;
+
+    bench::SilenceLogger();
+    std::vector<int> fds;
+    for (int i = 0; i < channels; ++i) {
+        fds.push_back(eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC));  // 计数非 0, 一直可读
+    }
+
+    EventLoop loop;
+    printf("channels: %d\n", channels);
+    printf("%-10s %22s %22s %10s\n", "case", "tie+function events/s", "handler events/s", "speedup");
+    double tied = RunDispatch(&loop, fds, false, total);
+    double handler = RunDispatch(&loop, fds, true, total);
+    printf("%-10s %22.0f %22.0f %9.2fx\n", "dispatch", tied, handler, handler / tied);
+    fflush(stdout);
+    tied = RunLoop(&loop, fds, false, total / 10);
+    handler = RunLoop(&loop, fds, true, total / 10);
+    printf("%-10s %22.0f %22.0f %9.2fx\n", "loop", tied, handler, handler / tied);
+
+    for (int fd : fds) {
+        close(fd);
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+// 连接风暴基准: 客户端不停地 建立连接 -> 发 1 字节 -> 收到回显 -> 关闭(RST), 统计每秒完成的连接数
+// 以及服务端每个连接的堆分配次数(本程序替换了全局 operator new, 统计包括库内的所有分配)
+// 用法: conn_storm_bench [Subloop 线程数=2] [并发连接数=64] [秒数=3]
+
+#include <signal.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+#include <thread>
+//
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+#include <cutemuduo/tcp_server.hpp>
+//
+#include "bench_util.hpp"
+
+// =================== 统计堆分配次数 ===================
+
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+// NOTE: 转给 unsized 版本, 只有一处直接 free(否则 GCC 的 -Wmismatched-new-delete 会报 sized delete 与 new 不匹配)
+void operator delete(void* p, size_t) noexcept {
+    ::operator delete(p);
+}
+
+using namespace cutemuduo;
+
+struct StormResult {
+    uint64_t completed = 0;  // 完成的连接数
+    uint64_t errors = 0;     // 连接失败/异常
+    double seconds = 0;
+};
+
+// conns 个槽位, 每个槽位上一个连接完成后立即开始下一个
+// NOTE: 关闭时 SO_LINGER=0 发送 RST, 客户端不进入 TIME_WAIT, 不会耗尽临时端口
+static StormResult RunStormClient(uint16_t port, int conns, std::chrono::milliseconds duration) {
+    struct Slot {
+        int fd = -1;
+        bool connected = false;
+    };
+    StormResult result;
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<Slot> slots(conns);
+    std::vector<epoll_event> events(1024);
+    sockaddr_in server{};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    uint32_t next_src = 0;
+
+    auto open = [&](int i) {
+        Slot& s = slots[i];
+        s.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        s.connected = false;
+        int one = 1;
+        setsockopt(s.fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+        linger lg{1, 0};
+        setsockopt(s.fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        sockaddr_in local{};
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + next_src++ % 16);
+        bind(s.fd, reinterpret_cast<sockaddr*>(&local), sizeof(local));
+        connect(s.fd, reinterpret_cast<sockaddr*>(&server), sizeof(server));
+        epoll_event ev{};
+        ev.events = EPOLLOUT;
+        ev.data.u32 = static_cast<uint32_t>(i);
+        epoll_ctl(epfd, EPOLL_CTL_ADD, s.fd, &ev);
+    };
+    auto reopen = [&](int i) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, slots[i].fd, nullptr);
+        close(slots[i].fd);
+        open(i);
+    };
+
+    for (int i = 0; i < conns; ++i) {
+        open(i);
+    }
+    int64_t start = bench::NowNs();
+    int64_t end = start + std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    while (bench::NowNs() < end) {
+        int n = epoll_wait(epfd, events.data(), static_cast<int>(events.size()), 100);
+        for (int k = 0; k < n; ++k) {
+            int i = static_cast<int>(events[k].data.u32);
+            Slot& s = slots[i];
+            if (!s.connected) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(s.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err != 0 || write(s.fd, "x", 1) != 1) {
+                    ++result.errors;
+                    reopen(i);
+                    continue;
+                }
+                s.connected = true;
+                epoll_event ev{};
+                ev.events = EPOLLIN;
+                ev.data.u32 = static_cast<uint32_t>(i);
+                epoll_ctl(epfd, EPOLL_CTL_MOD, s.fd, &ev);
+            } else {
+                char c;
+                if (read(s.fd, &c, 1) == 1) {
+                    ++result.completed;
+                } else {
+                    ++result.errors;
+                }
+                reopen(i);
+            }
+        }
+    }
+    result.seconds = static_cast<double>(bench::NowNs() - start) / 1e9;
+    for (auto& s : slots) {
+        close(s.fd);
+    }
+    close(epfd);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    int threads = argc > 1 ? atoi(argv[1]) : 2;
+    int conns = argc > 2 ? atoi(argv[2]) : 64;
+    auto duration = std::chrono::milliseconds(static_cast<int>((argc > 3 ? atof(argv[3]) : 3.0) * 1000));
+
+    bench::SilenceLogger();
+    bench::RaiseFdLimit();
+    signal(SIGPIPE, SIG_IGN);  // 回显时对端可能已经 RST
+
+    uint16_t port = 19300;
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port), "StormBench");
+    server.SetThreadNum(threads);
+    server.SetConnectionCallback([](TcpConnectionPtr const&) {});
+    server.SetMessageCallback([](TcpConnectionPtr const& conn, Buffer* buf, Timestamp) { conn->Send(buf); });
+    server.Start();
+
+    StormResult warmup;
+    StormResult result;
+    uint64_t allocations = 0;
+    std::thread client([&] {
+        // 预热: 让各线程的内存池/容器达到稳定状态, 之后才开始统计
+        warmup = RunStormClient(port, conns, std::chrono::milliseconds(500));
+        uint64_t before = g_allocations.load(std::memory_order_relaxed);
+        result = RunStormClient(port, conns, duration);
+        allocations = g_allocations.load(std::memory_order_relaxed) - before;
+        loop.Quit();
+    });
+    loop.Loop();
+    client.join();
+
+    printf("sub loops: %d, concurrent: %d\n", threads, conns);
+    printf("%12s %10s %14s\n", "conns/s", "errors", "allocs/conn");
+    printf("%12.0f %10lu %14.2f\n", static_cast<double>(result.completed) / result.seconds, result.errors,
+           result.completed ? static_cast<double>(allocations) / static_cast<double>(result.completed) : 0.0);
+    return 0;
+}
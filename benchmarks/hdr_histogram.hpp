@@ -0,0 +1,90 @@
+#pragma once
+
+// HDR(High Dynamic Range)风格的延迟直方图: 对数-线性分桶, 相对误差 < 1/64(约 1.6%)
+// 0~127 每个值一个桶; 之后每个 2 的幂区间 [2^k, 2^(k+1)) 均分成 64 个桶
+// NOTE: 记录只是一次数组自增, 不分配内存; 每个线程一个直方图, 结束时 Merge
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace bench {
+
+class HdrHistogram {
+public:
+    static constexpr int kSubBucketBits = 7;  // 每个区间 2^(7-1) = 64 个桶
+    static constexpr int kSubBucketHalf = 1 << (kSubBucketBits - 1);
+    static constexpr int kMaxValueBits = 40;  // 最大记录值 2^40(纳秒约 18 分钟)
+    static constexpr int kBuckets = (kMaxValueBits - kSubBucketBits + 2) * kSubBucketHalf;
+
+    void Record(int64_t value) {
+        value = std::clamp<int64_t>(value, 0, (int64_t{1} << kMaxValueBits) - 1);
+        ++counts_[IndexOf(static_cast<uint64_t>(value))];
+        ++count_;
+        sum_ += value;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void Merge(HdrHistogram const& other) {
+        for (int i = 0; i < kBuckets; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t count() const { return count_; }
+
+    int64_t min() const { return count_ ? min_ : 0; }
+
+    int64_t max() const { return count_ ? max_ : 0; }
+
+    double mean() const { return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0; }
+
+    // 第 p (0~100) 百分位: 返回所在桶的上界(与 HdrHistogram 一致, 偏保守), 不超过记录到的最大值
+    int64_t ValueAtPercentile(double p) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        auto rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(count_) + 0.5);
+        rank = std::clamp<uint64_t>(rank, 1, count_);
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return std::min(HighestEquivalent(i), max_);
+            }
+        }
+        return max_;
+    }
+
+private:
+    static int IndexOf(uint64_t value) {
+        if (value < 2 * kSubBucketHalf) {
+            return static_cast<int>(value);
+        }
+        int shift = (63 - std::countl_zero(value)) - (kSubBucketBits - 1);  // value >> shift 落在 [64, 128)
+        return (shift + 1) * kSubBucketHalf + static_cast<int>((value >> shift) - kSubBucketHalf);
+    }
+
+    static int64_t HighestEquivalent(int index) {
+        if (index < 2 * kSubBucketHalf) {
+            return index;
+        }
+        int shift = index / kSubBucketHalf - 1;
+        int64_t low = static_cast<int64_t>(index % kSubBucketHalf + kSubBucketHalf) << shift;
+        return low + (int64_t{1} << shift) - 1;
+    }
+
+    std::array<uint64_t, kBuckets> counts_{};
+    uint64_t count_ = 0;
+    int64_t sum_ = 0;
+    int64_t min_ = INT64_MAX;
+    int64_t max_ = 0;
+};
+
+}  // namespace bench
@@ -0,0 +1,262 @@
+// 压测客户端(基于 TcpClient): T 个 loop 线程共 C 个连接, 向 echo 服务器发送固定大小的消息,
+// 统计吞吐和延迟分布(HDR 直方图, p50/p90/p99/p999)
+//
+// 用法: load_generator [选项]
+//   -h 地址(127.0.0.1)  -p 端口(9012)  -t 线程数(4)  -c 连接数(64)  -s 消息字节数(64)
+//   -d pipelining 深度(1): 闭环模式下每个连接保持的在途消息数
+//   -r 速率(0): 0 为闭环模式(收到回显后立即发送下一条); > 0 为开环模式, 所有连接合计每秒发送的消息数
+//   -T 压测秒数(10)  -w 预热秒数(1)
+// 例: xmake run echo_server & xmake run load_generator -t 4 -c 256 -s 128 -d 4
+//
+// NOTE: 开环模式按固定时间表发送, 延迟从计划发送时间算起(服务端变慢时不会少发, 避免 coordinated omission)
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+//
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/event_loop_thread.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/tcp_client.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+//
+#include "bench_util.hpp"
+#include "hdr_histogram.hpp"
+
+using namespace cutemuduo;
+
+struct Config {
+    std::string host = "127.0.0.1";
+    uint16_t port = 9012;
+    int threads = 4;
+    int connections = 64;
+    size_t size = 64;
+    int pipeline = 1;
+    double rate = 0;  // 0: 闭环
+    double seconds = 10;
+    double warmup = 1;
+};
+
+static std::atomic<bool> g_recording{false};  // 预热结束后开始统计
+static std::atomic<bool> g_stopping{false};   // 压测结束, 不再发送新消息
+
+// 一个 loop 线程上的所有连接(只在该 loop 线程中访问)
+class Worker {
+public:
+    Worker(Config const& config, int connections, double rate)
+        : config_(config), payload_(config.size, 'x'), num_connections_(connections), rate_(rate) {}
+
+    EventLoop* Start() { return loop_ = thread_.StartLoop(); }
+
+    EventLoop* loop() const { return loop_; }
+
+    // 建立连接
+    void Connect() {
+        for (int i = 0; i < num_connections_; ++i) {
+            auto conn = std::make_unique<Conn>();
+            auto raw = conn.get();
+            conn->client = std::make_unique<TcpClient>(loop_, InetAddress(config_.port, config_.host), "load");
+            conn->client->SetConnectionCallback([this, raw](TcpConnectionPtr const& conn_ptr) {
+                if (conn_ptr->IsConnected()) {
+                    conn_ptr->SetTcpNoDelay(true);
+                    raw->conn = conn_ptr;
+                    connected_.fetch_add(1);
+                } else {
+                    raw->conn.reset();
+                    connected_.fetch_sub(1);
+                    if (!g_stopping) {
+                        ++errors_;
+                    }
+                }
+            });
+            conn->client->SetMessageCallback(
+                [this, raw](TcpConnectionPtr const&, Buffer* buf, Timestamp) { OnMessage(raw, buf); });
+            conn->client->Connect();
+            conns_.push_back(std::move(conn));
+        }
+    }
+
+    int connected() const { return connected_.load(); }
+
+    // 开始发送
+    void Run() {
+        start_ns_ = bench::NowNs();
+        if (rate_ > 0) {
+            tick_ = loop_->RunEvery(std::chrono::milliseconds(1), [this] { Tick(); });
+            return;
+        }
+        for (auto& conn : conns_) {
+            for (int i = 0; i < config_.pipeline; ++i) {
+                Send(conn.get(), bench::NowNs());
+            }
+        }
+    }
+
+    // 停止并关闭所有连接(在 loop 线程中)
+    void Finish() {
+        loop_->CancelTimer(tick_);
+        // NOTE: TcpClient 析构时关闭连接, 期间的连接断开回调还会访问 Conn, 先析构 TcpClient
+        for (auto& conn : conns_) {
+            conn->client.reset();
+        }
+        conns_.clear();
+    }
+
+    bench::HdrHistogram const& histogram() const { return histogram_; }
+
+    uint64_t completed() const { return completed_; }
+
+    uint64_t errors() const { return errors_; }
+
+private:
+    struct Conn {
+        std::unique_ptr<TcpClient> client;
+        TcpConnectionPtr conn;
+        std::deque<int64_t> send_times;  // 在途消息的(计划)发送时间
+        size_t received = 0;             // 不足一条消息的已收字节数
+    };
+
+    void Send(Conn* conn, int64_t send_time) {
+        if (!conn->conn) {
+            ++errors_;
+            return;
+        }
+        conn->send_times.push_back(send_time);
+        conn->conn->SendInLoop(payload_.data(), payload_.size());
+    }
+
+    void OnMessage(Conn* conn, Buffer* buf) {
+        int64_t now = bench::NowNs();
+        conn->received += buf->ReadableBytes();
+        buf->RetrieveAll();
+        while (conn->received >= config_.size && !conn->send_times.empty()) {
+            conn->received -= config_.size;
+            int64_t sent = conn->send_times.front();
+            conn->send_times.pop_front();
+            if (g_recording.load(std::memory_order_relaxed)) {
+                histogram_.Record(now - sent);
+                ++completed_;
+            }
+            if (rate_ == 0 && !g_stopping.load(std::memory_order_relaxed)) {
+                Send(conn, now);
+            }
+        }
+    }
+
+    // 开环: 发送到目前为止按时间表应发的消息
+    void Tick() {
+        if (g_stopping) {
+            return;
+        }
+        int64_t now = bench::NowNs();
+        auto due = static_cast<uint64_t>(static_cast<double>(now - start_ns_) * rate_ / 1e9);
+        for (; scheduled_ < due; ++scheduled_) {
+            auto intended = start_ns_ + static_cast<int64_t>(static_cast<double>(scheduled_) * 1e9 / rate_);
+            Send(conns_[next_conn_++ % conns_.size()].get(), intended);
+        }
+    }
+
+    Config const& config_;
+    std::string const payload_;
+    int const num_connections_;
+    double const rate_;  // 本线程每秒发送的消息数(0: 闭环)
+    EventLoopThread thread_;
+    EventLoop* loop_ = nullptr;
+    std::vector<std::unique_ptr<Conn>> conns_;
+    std::atomic<int> connected_{0};
+    bench::HdrHistogram histogram_;
+    uint64_t completed_ = 0;
+    uint64_t errors_ = 0;
+    int64_t start_ns_ = 0;
+    uint64_t scheduled_ = 0;  // 开环: 已经发送的消息数
+    size_t next_conn_ = 0;    // 开环: 轮流使用各个连接
+    TimerId tick_;
+};
+
+static void Usage(char const* prog) {
+    fprintf(stderr, "usage: %s [-h host] [-p port] [-t threads] [-c connections] [-s size] [-d pipeline] "
+            "[-r rate] [-T seconds] [-w warmup]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    Config config;
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:t:c:s:d:r:T:w:")) != -1) {
+        switch (opt) {
+            case 'h': config.host = optarg; break;
+            case 'p': config.port = static_cast<uint16_t>(atoi(optarg)); break;
+            case 't': config.threads = std::max(atoi(optarg), 1); break;
+            case 'c': config.connections = std::max(atoi(optarg), 1); break;
+            case 's': config.size = std::max<size_t>(strtoul(optarg, nullptr, 10), 1); break;
+            case 'd': config.pipeline = std::max(atoi(optarg), 1); break;
+            case 'r': config.rate = atof(optarg); break;
+            case 'T': config.seconds = atof(optarg); break;
+            case 'w': config.warmup = atof(optarg); break;
+            default: Usage(argv[0]);
+        }
+    }
+    config.threads = std::min(config.threads, config.connections);
+
+    bench::SilenceLogger();
+    bench::RaiseFdLimit();
+    signal(SIGPIPE, SIG_IGN);
+
+    // 1. 建立连接(平均分给各个线程)
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < config.threads; ++i) {
+        int conns = config.connections / config.threads + (i < config.connections % config.threads ? 1 : 0);
+        workers.push_back(std::make_unique<Worker>(config, conns, config.rate * conns / config.connections));
+        auto worker = workers.back().get();
+        worker->Start()->RunInLoop([worker] { worker->Connect(); });
+    }
+    int connected = bench::WaitConnected(workers, config.connections, std::chrono::seconds(10));
+    if (connected < config.connections) {
+        fprintf(stderr, "only %d of %d connections established to %s:%u\n", connected, config.connections,
+                config.host.c_str(), config.port);
+    }
+
+    // 2. 预热, 压测
+    bench::RunAll(workers, [](Worker* worker) { worker->Run(); });
+    std::this_thread::sleep_for(std::chrono::duration<double>(config.warmup));
+    g_recording = true;
+    int64_t start = bench::NowNs();
+    std::this_thread::sleep_for(std::chrono::duration<double>(config.seconds));
+    g_recording = false;
+    double elapsed = static_cast<double>(bench::NowNs() - start) / 1e9;
+    g_stopping = true;
+    bench::RunAll(workers, [](Worker* worker) { worker->Finish(); });
+
+    // 3. 汇总
+    bench::HdrHistogram histogram;
+    uint64_t completed = 0;
+    uint64_t errors = 0;
+    for (auto& worker : workers) {
+        histogram.Merge(worker->histogram());
+        completed += worker->completed();
+        errors += worker->errors();
+    }
+    double msgs = static_cast<double>(completed) / elapsed;
+    printf("target %s:%u, threads %d, connections %d (%d up), size %zu B, ", config.host.c_str(), config.port,
+           config.threads, config.connections, connected, config.size);
+    if (config.rate > 0) {
+        printf("open loop %.0f msg/s, %.1f s\n", config.rate, config.seconds);
+    } else {
+        printf("closed loop pipeline %d, %.1f s\n", config.pipeline, config.seconds);
+    }
+    printf("%12s %10s %10s\n", "msgs/s", "MiB/s", "errors");
+    printf("%12.0f %10.2f %10lu\n", msgs, msgs * static_cast<double>(config.size) / (1024 * 1024), errors);
+    printf("%12s %10s %10s %10s %10s %10s %10s\n", "latency(us)", "p50", "p90", "p99", "p999", "max", "mean");
+    printf("%12s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", "", histogram.ValueAtPercentile(50) / 1e3,
+           histogram.ValueAtPercentile(90) / 1e3, histogram.ValueAtPercentile(99) / 1e3,
+           histogram.ValueAtPercentile(99.9) / 1e3, histogram.max() / 1e3, histogram.mean() / 1e3);
+    return 0;
+}
@@ -0,0 +1,389 @@
+// 核心组件微基准, 结果以 JSON 输出到标准输出(每个用例一行), 方便在不同提交之间 diff
+// 用法: micro_bench [用例名过滤子串]    例: micro_bench buffer/ > before.json
+//
+// - buffer/*:        Buffer Append / Retrieve / ReadFd / FindCRLF
+// - queue_in_loop/*: 1~8 个生产者线程 QueueInLoop 到同一个 loop 的吞吐
+// - run_in_loop/*:   其他线程 RunInLoop 到任务开始执行的延迟(包括唤醒)
+// - poller/*:        EpollPoller 注册(EPOLL_CTL_ADD)/修改(MOD)/移除(DEL)一个 Channel 的开销
+// - channel/*:       Channel::HandleEvent 分发一个可读事件的开销(std::function 回调 / ChannelHandler)
+// - tcp_send/*:      TcpConnection::Send 经 socketpair 发送到另一个线程读走的吞吐
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+//
+#include <cutemuduo/block_pool.hpp>
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/channel.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/event_loop_thread.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+//
+#include "bench_util.hpp"
+#include "hdr_histogram.hpp"
+
+using namespace cutemuduo;
+
+// 防止编译器把被测代码优化掉
+template <typename T>
+static void DoNotOptimize(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class JsonReport {
+public:
+    explicit JsonReport(std::string filter) : filter_(std::move(filter)) {}
+
+    bool Enabled(std::string const& name) const { return name.find(filter_) != std::string::npos; }
+
+    // metrics: {指标名, 值}, 例如 {"ns_per_op", 3.2}
+    void Add(std::string const& name, uint64_t iterations, std::vector<std::pair<char const*, double>> metrics) {
+        printf("%s\n    {\"name\": \"%s\", \"iterations\": %lu", first_ ? "" : ",", name.c_str(), iterations);
+        for (auto& [key, value] : metrics) {
+            printf(", \"%s\": %.2f", key, value);
+        }
+        printf("}");
+        fflush(stdout);
+        first_ = false;
+    }
+
+    void Begin() {
+        printf("{\n  \"cpus\": %u,\n  \"benchmarks\": [", std::thread::hardware_concurrency());
+    }
+
+    void End() { printf("\n  ]\n}\n"); }
+
+private:
+    std::string filter_;
+    bool first_ = true;
+};
+
+// 运行 fn(iterations) 并返回每次操作的纳秒数
+template <typename Fn>
+static double NsPerOp(uint64_t iterations, Fn&& fn) {
+    int64_t start = bench::NowNs();
+    fn(iterations);
+    return static_cast<double>(bench::NowNs() - start) / static_cast<double>(iterations);
+}
+
+// =================== Buffer ===================
+
+static void BenchBuffer(JsonReport& report) {
+    constexpr uint64_t kIterations = 10000000;
+    for (size_t size : {16, 256, 4096}) {
+        std::string data(size, 'x');
+        std::string name = "buffer/append_retrieve/" + std::to_string(size);
+        if (report.Enabled(name)) {
+            Buffer buf;
+            double ns = NsPerOp(kIterations, [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) {
+                    buf.Append(data.data(), data.size());
+                    if (buf.ReadableBytes() >= 64 * 1024) {
+                        buf.Retrieve(buf.ReadableBytes() / 2);  // 保留一半, Append 需要挪动或扩容
+                    }
+                }
+            });
+            DoNotOptimize(buf.ReadableBytes());
+            report.Add(name, kIterations, {{"ns_per_op", ns}, {"mib_per_sec", size * 1e9 / ns / (1 << 20)}});
+        }
+    }
+
+    if (report.Enabled("buffer/find_crlf/4096")) {
+        Buffer buf;
+        std::string line(4094, 'x');
+        line += "\r\n";
+        buf.Append(line.data(), line.size());
+        double ns = NsPerOp(kIterations / 10, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                DoNotOptimize(buf.FindCRLF());
+            }
+        });
+        report.Add("buffer/find_crlf/4096", kIterations / 10, {{"ns_per_op", ns}});
+    }
+
+    // ReadFd: 每次先向 socketpair 写入 size 字节, 只计 ReadFd 的时间
+    for (size_t size : {64, 16384, 131072}) {
+        std::string name = "buffer/read_fd/" + std::to_string(size);
+        if (!report.Enabled(name)) {
+            continue;
+        }
+        int fds[2];
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds);
+        int sndbuf = 4 << 20;
+        setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        std::string data(size, 'x');
+        Buffer buf;
+        uint64_t iterations = 200000;
+        int64_t total = 0;
+        int saved_errno = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            size_t written = 0;
+            while (written < size) {
+                written += static_cast<size_t>(std::max<ssize_t>(write(fds[0], data.data() + written, size - written), 0));
+            }
+            int64_t start = bench::NowNs();
+            size_t got = 0;
+            while (got < size) {
+                got += static_cast<size_t>(std::max<ssize_t>(buf.ReadFd(fds[1], &saved_errno), 0));
+            }
+            total += bench::NowNs() - start;
+            buf.RetrieveAll();
+        }
+        double ns = static_cast<double>(total) / static_cast<double>(iterations);
+        report.Add(name, iterations, {{"ns_per_op", ns}, {"mib_per_sec", size * 1e9 / ns / (1 << 20)}});
+        close(fds[0]);
+        close(fds[1]);
+    }
+}
+
+// =================== EventLoop ===================
+
+static void BenchQueueInLoop(JsonReport& report, EventLoop* loop) {
+    constexpr long kTasksPerProducer = 500000;
+    for (int producers : {1, 2, 4, 8}) {
+        std::string name = "queue_in_loop/producers_" + std::to_string(producers);
+        if (!report.Enabled(name)) {
+            continue;
+        }
+        std::atomic<long> done{0};
+        long total = producers * kTasksPerProducer;
+        int64_t start = bench::NowNs();
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&] {
+                for (long i = 0; i < kTasksPerProducer; ++i) {
+                    loop->QueueInLoop([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        while (done.load(std::memory_order_relaxed) < total) {
+            std::this_thread::yield();
+        }
+        double seconds = static_cast<double>(bench::NowNs() - start) / 1e9;
+        report.Add(name, static_cast<uint64_t>(total), {{"tasks_per_sec", static_cast<double>(total) / seconds}});
+    }
+}
+
+static void BenchRunInLoop(JsonReport& report, EventLoop* loop) {
+    if (!report.Enabled("run_in_loop/latency")) {
+        return;
+    }
+    // NOTE: 每次等上一个任务执行完再投递, loop 每次都阻塞在 epoll_wait 中, 测的是跨线程唤醒的完整延迟
+    constexpr uint64_t kSamples = 20000;
+    bench::HdrHistogram histogram;
+    for (uint64_t i = 0; i < kSamples; ++i) {
+        std::atomic<int64_t> ran{0};
+        int64_t posted = bench::NowNs();
+        loop->RunInLoop([&ran] { ran.store(bench::NowNs(), std::memory_order_release); });
+        int64_t t;
+        while ((t = ran.load(std::memory_order_acquire)) == 0) {
+        }
+        histogram.Record(t - posted);
+    }
+    report.Add("run_in_loop/latency", kSamples,
+               {{"p50_ns", static_cast<double>(histogram.ValueAtPercentile(50))},
+                {"p99_ns", static_cast<double>(histogram.ValueAtPercentile(99))},
+                {"mean_ns", histogram.mean()}});
+}
+
+// =================== EpollPoller / Channel ===================
+
+static void BenchPoller(JsonReport& report, EventLoop* loop) {
+    if (!report.Enabled("poller/")) {
+        return;
+    }
+    constexpr uint64_t kIterations = 200000;
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Channel channel(loop, fd);
+    int64_t add = 0;
+    int64_t mod = 0;
+    int64_t del = 0;
+    for (uint64_t i = 0; i < kIterations; ++i) {
+        int64_t t0 = bench::NowNs();
+        channel.EnableReading();  // EPOLL_CTL_ADD
+        int64_t t1 = bench::NowNs();
+        channel.EnableWriting();  // EPOLL_CTL_MOD
+        int64_t t2 = bench::NowNs();
+        channel.DisableAll();  // EPOLL_CTL_DEL(没有关注的事件时从 epoll 中删除)
+        channel.Remove();
+        int64_t t3 = bench::NowNs();
+        add += t1 - t0;
+        mod += t2 - t1;
+        del += t3 - t2;
+    }
+    auto per_op = [](int64_t total) { return static_cast<double>(total) / static_cast<double>(kIterations); };
+    report.Add("poller/add", kIterations, {{"ns_per_op", per_op(add)}});
+    report.Add("poller/mod", kIterations, {{"ns_per_op", per_op(mod)}});
+    report.Add("poller/remove", kIterations, {{"ns_per_op", per_op(del)}});
+    close(fd);
+}
+
+class CountingHandler : public ChannelHandler {
+public:
+    void HandleRead(Timestamp) override { ++events; }
+
+    void HandleWrite() override {}
+
+    void HandleClose() override {}
+
+    void HandleError() override {}
+
+    uint64_t events = 0;
+};
+
+static void BenchChannel(JsonReport& report, EventLoop* loop) {
+    constexpr uint64_t kIterations = 50000000;
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Timestamp now = Timestamp::Now();
+    if (report.Enabled("channel/dispatch_function")) {
+        Channel channel(loop, fd);
+        uint64_t events = 0;
+        channel.SetReadCallback([&events](Timestamp) { ++events; });
+        channel.SetRevents(EPOLLIN);
+        double ns = NsPerOp(kIterations, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                channel.HandleEvent(now);
+            }
+        });
+        DoNotOptimize(events);
+        report.Add("channel/dispatch_function", kIterations, {{"ns_per_op", ns}});
+    }
+    if (report.Enabled("channel/dispatch_handler")) {
+        Channel channel(loop, fd);
+        CountingHandler handler;
+        channel.SetHandler(&handler);
+        channel.SetRevents(EPOLLIN);
+        double ns = NsPerOp(kIterations, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                channel.HandleEvent(now);
+            }
+        });
+        DoNotOptimize(handler.events);
+        report.Add("channel/dispatch_handler", kIterations, {{"ns_per_op", ns}});
+    }
+    close(fd);
+}
+
+// =================== TcpConnection ===================
+
+// loop 线程中不停 Send, 另一个线程从 socketpair 的另一端(阻塞地)读走;
+// 未读走的数据超过 4 MiB 时暂停发送, 等输出缓冲区写完(WriteCompleteCallback)再继续
+static void BenchTcpSend(JsonReport& report, EventLoop* loop) {
+    for (size_t size : {64, 4096}) {
+        std::string name = "tcp_send/" + std::to_string(size);
+        if (!report.Enabled(name)) {
+            continue;
+        }
+        uint64_t const messages = size < 1024 ? 10000000 : 1000000;
+        uint64_t const total_bytes = messages * size;
+        int fds[2];
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds);
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);  // 只有发送端(TcpConnection)是非阻塞的
+        std::atomic<uint64_t> received{0};
+        std::thread reader([&] {
+            std::vector<char> buf(256 * 1024);
+            while (received.load(std::memory_order_relaxed) < total_bytes) {
+                ssize_t n = read(fds[1], buf.data(), buf.size());
+                if (n <= 0) {
+                    break;
+                }
+                received.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+            }
+        });
+
+        std::string const payload(size, 'x');
+        uint64_t sent = 0;
+        bool throttled = false;
+        TcpConnectionPtr conn;
+        std::function<void()> pump = [&] {
+            // 每次最多发 256 条, 之后让 loop 处理一轮 IO(输出缓冲区经 EPOLLOUT 写出)
+            for (int i = 0; i < 256 && sent < messages; ++i) {
+                if (sent * size - received.load(std::memory_order_relaxed) > (4u << 20)) {
+                    throttled = true;
+                    return;
+                }
+                conn->Send(payload);
+                ++sent;
+            }
+            if (sent < messages) {
+                loop->QueueInLoop([&] { pump(); });
+            }
+        };
+        int64_t start = bench::NowNs();
+        loop->RunInLoop([&] {
+            auto prefix = std::make_shared<std::string const>("micro");
+            conn = std::allocate_shared<TcpConnection>(BlockAllocator<TcpConnection>(), loop, 1, prefix, fds[0],
+                                                       InetAddress(), InetAddress());
+            conn->SetConnectionCallback([](TcpConnectionPtr const&) {});
+            conn->SetMessageCallback([](TcpConnectionPtr const&, Buffer* buf, Timestamp) { buf->RetrieveAll(); });
+            conn->SetCloseCallback([loop](TcpConnectionPtr const& c) {
+                loop->QueueInLoop([c] { c->ConnectDestroyed(); });
+            });
+            conn->SetWriteCompleteCallback([&](TcpConnectionPtr const&) {
+                if (throttled) {
+                    throttled = false;
+                    pump();
+                }
+            });
+            conn->ConnectEstablished();
+            pump();
+        });
+        reader.join();
+        double seconds = static_cast<double>(bench::NowNs() - start) / 1e9;
+        report.Add(name, messages,
+                   {{"msgs_per_sec", static_cast<double>(messages) / seconds},
+                    {"mib_per_sec", static_cast<double>(total_bytes) / seconds / (1 << 20)}});
+
+        // 关闭连接(fd 由 TcpConnection 的 Socket 关闭)
+        std::promise<void> closed;
+        loop->RunInLoop([&] {
+            conn->ForceClose();
+            conn.reset();
+            loop->QueueInLoop([&closed] { closed.set_value(); });
+        });
+        closed.get_future().wait();
+        close(fds[1]);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    JsonReport report(argc > 1 ? argv[1] : "");
+    bench::SilenceLogger();
+
+    report.Begin();
+    BenchBuffer(report);
+    {
+        EventLoop loop;  // Poller/Channel 直接在本线程的 loop 上操作(不运行 Loop)
+        BenchPoller(report, &loop);
+        BenchChannel(report, &loop);
+    }
+    {
+        EventLoopThread loop_thread;
+        EventLoop* loop = loop_thread.StartLoop();
+        // NOTE: Loop() 开始时会重置 quit_, 用例全被过滤掉时 loop 可能还没进入 Loop() 就被析构中的 Quit() 结束,
+        // 先等一个任务执行完, 确认 loop 已经开始循环
+        std::promise<void> started;
+        loop->RunInLoop([&started] { started.set_value(); });
+        started.get_future().wait();
+        BenchQueueInLoop(report, loop);
+        BenchRunInLoop(report, loop);
+        BenchTcpSend(report, loop);
+    }
+    report.End();
+    return 0;
+}
@@ -0,0 +1,207 @@
+// pingpong 吞吐测试的客户端(同 muduo 的 pingpong 测试): T 个 loop 线程共 C 个连接,
+// 每个连接建立后发出一个 B 字节的消息, 之后收到什么就原样发回去, 消息在客户端和服务端之间来回弹,
+// 持续 -T 秒, 统计客户端收到的字节数: MiB/s 和 messages/s(= 字节数 / B)
+// 整条 TcpConnection / Buffer / EpollPoller 路径都在其中, 可以作为改动前后对比的固定数字
+//
+// 用法: pingpong_client [选项]
+//   -h 地址(127.0.0.1)  -p 端口(9016)  -t 线程数(4)  -c 连接数(1)  -s 消息字节数(16384)  -T 每次测试的秒数(10)
+//   -m: 跑标准矩阵(消息 16B~1MiB x 连接数 1~10k x 线程数 1/-t), 忽略 -c/-s
+// 例: xmake run pingpong_server -t 4 & xmake run pingpong_client -t 4 -c 100 -s 4096
+//
+// NOTE: 矩阵中跳过 消息大小 x 连接数 > 256 MiB 的组合(在途数据全在两端的缓冲区中);
+// 每次测试结束由客户端主动关闭连接, 连续多次 10k 连接的测试依赖回环地址上的 TIME_WAIT 复用(tcp_tw_reuse)
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+//
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/event_loop_thread.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/tcp_client.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+//
+#include "bench_util.hpp"
+
+using namespace cutemuduo;
+
+struct Config {
+    std::string host = "127.0.0.1";
+    uint16_t port = 9016;
+    int threads = 4;
+    int connections = 1;
+    size_t size = 16384;
+    double seconds = 10;
+};
+
+struct Result {
+    int connected = 0;
+    double mib_per_sec = 0;
+    double msgs_per_sec = 0;
+};
+
+// 一个 loop 线程上的所有连接(只在该 loop 线程中访问)
+class Worker {
+public:
+    Worker(Config const& config, int connections)
+        : config_(config), payload_(config.size, 'x'), num_connections_(connections) {}
+
+    EventLoop* Start() { return loop_ = thread_.StartLoop(); }
+
+    EventLoop* loop() const { return loop_; }
+
+    // 建立连接, 连接建立后发出第一个消息
+    void Connect() {
+        for (int i = 0; i < num_connections_; ++i) {
+            auto client = std::make_unique<TcpClient>(loop_, InetAddress(config_.port, config_.host), "pingpong");
+            client->SetConnectionCallback([this](TcpConnectionPtr const& conn_ptr) {
+                if (conn_ptr->IsConnected()) {
+                    conn_ptr->SetTcpNoDelay(true);
+                    conn_ptr->SendInLoop(payload_.data(), payload_.size());
+                    connected_.fetch_add(1);
+                } else {
+                    connected_.fetch_sub(1);
+                }
+            });
+            client->SetMessageCallback([this](TcpConnectionPtr const& conn_ptr, Buffer* buf, Timestamp) {
+                bytes_read_ += buf->ReadableBytes();
+                conn_ptr->Send(buf);
+            });
+            client->Connect();
+            clients_.push_back(std::move(client));
+        }
+    }
+
+    int connected() const { return connected_.load(); }
+
+    // 到目前为止收到的字节数(在 loop 线程中调用)
+    uint64_t bytes_read() const { return bytes_read_; }
+
+    // 关闭所有连接(在 loop 线程中)
+    void Finish() { clients_.clear(); }
+
+private:
+    Config const& config_;
+    std::string const payload_;
+    int const num_connections_;
+    EventLoopThread thread_;
+    EventLoop* loop_ = nullptr;
+    std::vector<std::unique_ptr<TcpClient>> clients_;
+    std::atomic<int> connected_{0};
+    uint64_t bytes_read_ = 0;
+};
+
+static uint64_t TotalBytesRead(std::vector<std::unique_ptr<Worker>>& workers) {
+    std::atomic<uint64_t> total{0};
+    bench::RunAll(workers, [&total](Worker* worker) { total.fetch_add(worker->bytes_read()); });
+    return total.load();
+}
+
+static Result Run(Config const& config) {
+    int threads = std::min(config.threads, config.connections);
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < threads; ++i) {
+        int conns = config.connections / threads + (i < config.connections % threads ? 1 : 0);
+        workers.push_back(std::make_unique<Worker>(config, conns));
+        auto worker = workers.back().get();
+        worker->Start()->RunInLoop([worker] { worker->Connect(); });
+    }
+
+    Result result;
+    result.connected = bench::WaitConnected(workers, config.connections, std::chrono::seconds(30));
+    if (result.connected < config.connections) {
+        fprintf(stderr, "only %d of %d connections established to %s:%u\n", result.connected, config.connections,
+                config.host.c_str(), config.port);
+    }
+
+    // NOTE: 从所有连接都建立之后开始计时(连接建立期间已经在收发的数据不计入)
+    uint64_t start_bytes = TotalBytesRead(workers);
+    int64_t start = bench::NowNs();
+    std::this_thread::sleep_for(std::chrono::duration<double>(config.seconds));
+    uint64_t bytes = TotalBytesRead(workers) - start_bytes;
+    double elapsed = static_cast<double>(bench::NowNs() - start) / 1e9;
+    bench::RunAll(workers, [](Worker* worker) { worker->Finish(); });
+
+    result.mib_per_sec = static_cast<double>(bytes) / elapsed / (1024 * 1024);
+    result.msgs_per_sec = static_cast<double>(bytes) / static_cast<double>(config.size) / elapsed;
+    return result;
+}
+
+static void PrintHeader() {
+    printf("%8s %12s %8s %12s %14s\n", "threads", "connections", "size", "MiB/s", "msgs/s");
+}
+
+static void PrintResult(Config const& config, Result const& result) {
+    printf("%8d %12d %8zu %12.2f %14.0f", std::min(config.threads, config.connections), config.connections,
+           config.size, result.mib_per_sec, result.msgs_per_sec);
+    if (result.connected < config.connections) {
+        printf("   (%d connected)", result.connected);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+static void Usage(char const* prog) {
+    fprintf(stderr, "usage: %s [-h host] [-p port] [-t threads] [-c connections] [-s size] [-T seconds] [-m]\n",
+            prog);
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    Config config;
+    bool matrix = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:t:c:s:T:m")) != -1) {
+        switch (opt) {
+            case 'h': config.host = optarg; break;
+            case 'p': config.port = static_cast<uint16_t>(atoi(optarg)); break;
+            case 't': config.threads = std::max(atoi(optarg), 1); break;
+            case 'c': config.connections = std::max(atoi(optarg), 1); break;
+            case 's': config.size = std::max<size_t>(strtoul(optarg, nullptr, 10), 1); break;
+            case 'T': config.seconds = atof(optarg); break;
+            case 'm': matrix = true; break;
+            default: Usage(argv[0]);
+        }
+    }
+
+    bench::SilenceLogger();
+    bench::RaiseFdLimit();
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("target %s:%u, %.1f s per run\n", config.host.c_str(), config.port, config.seconds);
+    PrintHeader();
+    if (!matrix) {
+        PrintResult(config, Run(config));
+        return 0;
+    }
+
+    std::vector<int> thread_counts{1};
+    if (config.threads > 1) {
+        thread_counts.push_back(config.threads);
+    }
+    for (int threads : thread_counts) {
+        for (size_t size : {16, 1024, 16 * 1024, 64 * 1024, 1024 * 1024}) {
+            for (int connections : {1, 10, 100, 1000, 10000}) {
+                // 连接数少于线程数时实际线程数同上一组, 不重复测
+                if (size * static_cast<size_t>(connections) > (256u << 20) || connections < threads) {
+                    continue;
+                }
+                Config run = config;
+                run.threads = threads;
+                run.size = size;
+                run.connections = connections;
+                PrintResult(run, Run(run));
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));  // 等服务端关闭上一轮的连接
+            }
+        }
+    }
+    return 0;
+}
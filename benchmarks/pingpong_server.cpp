@@ -0,0 +1,58 @@
+// pingpong 吞吐测试的服务端(同 muduo 的 pingpong 测试): 收到什么就原样发回去, 配合 pingpong_client 使用
+//
+// 用法: pingpong_server [-p 端口(9016)] [-t Subloop 线程数(4)] [-r]
+//   -r: kReusePortPerLoop, 每个 Subloop 一个 SO_REUSEPORT 监听 socket(大量连接时不经过 Mainloop 转交)
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cstdio>
+//
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+#include <cutemuduo/tcp_server.hpp>
+//
+#include "bench_util.hpp"
+
+using namespace cutemuduo;
+
+int main(int argc, char* argv[]) {
+    uint16_t port = 9016;
+    int threads = 4;
+    auto option = TcpServer::Option::kNoReusePort;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:t:r")) != -1) {
+        switch (opt) {
+            case 'p': port = static_cast<uint16_t>(atoi(optarg)); break;
+            case 't': threads = std::max(atoi(optarg), 0); break;
+            case 'r': option = TcpServer::Option::kReusePortPerLoop; break;
+            default:
+                fprintf(stderr, "usage: %s [-p port] [-t threads] [-r]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    bench::SilenceLogger();
+    bench::RaiseFdLimit();
+    signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port), "PingPongServer", option);
+    server.SetConnectionCallback([](TcpConnectionPtr const& conn_ptr) {
+        if (conn_ptr->IsConnected()) {
+            conn_ptr->SetTcpNoDelay(true);
+        }
+    });
+    // NOTE: 输入缓冲区整个发回去, 不拷贝成 std::string
+    server.SetMessageCallback([](TcpConnectionPtr const& conn_ptr, Buffer* buf, Timestamp) { conn_ptr->Send(buf); });
+    server.SetThreadNum(threads);
+    server.Start();
+    printf("pingpong server listening on port %u, %d threads\n", port, threads);
+    fflush(stdout);
+    loop.Loop();
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Poller 后端对比: 相同的 echo 负载分别跑在 poll / epoll 上
+// 用法: poller_bench [每组秒数=3] [消息字节数=64]
+
+#include <stdlib.h>
+
+#include <string>
+#include <thread>
+//
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+#include <cutemuduo/tcp_server.hpp>
+//
+#include "bench_util.hpp"
+
+using namespace cutemuduo;
+
+static bench::EchoResult RunCase(std::string const& backend, uint16_t port, int conns, size_t msg_size,
+                                 std::chrono::milliseconds duration, EventLoopStats* stats) {
+    // NOTE: NewDefaultPoller 在构造 EventLoop 时读取环境变量
+    if (backend == "poll") {
+        setenv("CUTEMUDUO_USE_POLL", "1", 1);
+    } else {
+        unsetenv("CUTEMUDUO_USE_POLL");
+    }
+
+    bench::EchoResult result;
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port), "PollerBench");
+    server.SetConnectionCallback([](TcpConnectionPtr const&) {});
+    server.SetMessageCallback([](TcpConnectionPtr const& conn, Buffer* buf, Timestamp) { conn->Send(buf); });
+    server.Start();
+
+    std::thread client([&] {
+        result = bench::RunEchoClient(port, conns, msg_size, duration);
+        loop.Quit();
+    });
+    loop.Loop();
+    client.join();
+    *stats = loop.GetStats();
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    auto duration = std::chrono::milliseconds(static_cast<int>((argc > 1 ? atof(argv[1]) : 3.0) * 1000));
+    size_t msg_size = argc > 2 ? static_cast<size_t>(atoi(argv[2])) : 64;
+
+    bench::SilenceLogger();
+    long fd_limit = bench::RaiseFdLimit();
+
+    char const* const backends[] = {"poll", "epoll"};
+    int const conn_counts[] = {10, 1000, 50000};
+
+    printf("%-10s %8s %12s %10s %10s %8s %10s\n", "backend", "conns", "msgs/s", "p50(us)", "p99(us)", "errors",
+           "ev/poll");
+    uint16_t port = 19100;
+    for (char const* backend : backends) {
+        for (int conns : conn_counts) {
+            ++port;
+            // 客户端和服务端在同一进程, 每个连接占 2 个 fd
+            if (2L * conns + 64 > fd_limit) {
+                printf("%-10s %8d %12s (RLIMIT_NOFILE=%ld)\n", backend, conns, "skipped", fd_limit);
+                continue;
+            }
+            EventLoopStats stats;
+            auto r = RunCase(backend, port, conns, msg_size, duration, &stats);
+            printf("%-10s %8d %12.0f %10.1f %10.1f %8lu %10.1f\n", backend, r.connected,
+                   static_cast<double>(r.messages) / r.seconds, r.p50_us, r.p99_us, r.errors, stats.EventsPerPoll());
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+// EventLoop::QueueInLoop 多生产者竞争基准
+// 用法: queue_in_loop_bench [每个生产者的任务数=200000]
+//
+// 1. EventLoop: 1~32 个生产者线程同时向同一个 loop QueueInLoop, 统计 loop 执行完所有任务的吞吐,
+//    以及实际写 eventfd / 被合并掉的唤醒次数
+// 2. 队列本身: MpscQueue 与原先的 mutex + vector(swap) 方案在相同消费模式下对比
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+//
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/event_loop_thread.hpp>
+#include <cutemuduo/mpsc_queue.hpp>
+//
+#include "bench_util.hpp"
+
+using namespace cutemuduo;
+
+// 原先 EventLoop 中的实现: 生产者加锁 push_back, 消费者加锁 swap
+class MutexQueue {
+public:
+    void Push(int v) {
+        std::unique_lock lk{mtx_};
+        items_.push_back(v);
+    }
+
+    template <typename Fn>
+    size_t ConsumeAll(Fn&& fn) {
+        std::vector<int> items;
+        {
+            std::unique_lock lk{mtx_};
+            items.swap(items_);
+        }
+        for (int& v : items) {
+            fn(v);
+        }
+        return items.size();
+    }
+
+private:
+    std::mutex mtx_;
+    std::vector<int> items_;
+};
+
+static double RunLoopCase(EventLoop* loop, int producers, int per_producer) {
+    std::atomic<long> done{0};
+    long total = static_cast<long>(producers) * per_producer;
+    int64_t start = bench::NowNs();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < per_producer; ++i) {
+                loop->QueueInLoop([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    while (done.load(std::memory_order_relaxed) < total) {
+        std::this_thread::yield();
+    }
+    return static_cast<double>(total) / (static_cast<double>(bench::NowNs() - start) / 1e9);
+}
+
+template <typename Queue>
+static double RunQueueCase(int producers, int per_producer) {
+    Queue queue;
+    long total = static_cast<long>(producers) * per_producer;
+    long consumed = 0;
+    int64_t start = bench::NowNs();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < per_producer; ++i) {
+                queue.Push(i);
+            }
+        });
+    }
+    while (consumed < total) {
+        size_t n = queue.ConsumeAll([](int&) {});
+        consumed += static_cast<long>(n);
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    return static_cast<double>(total) / (static_cast<double>(bench::NowNs() - start) / 1e9);
+}
+
+int main(int argc, char* argv[]) {
+    int per_producer = argc > 1 ? atoi(argv[1]) : 200000;
+    int const producer_counts[] = {1, 2, 4, 8, 16, 32};
+
+    bench::SilenceLogger();
+    EventLoopThread loop_thread;
+    EventLoop* loop = loop_thread.StartLoop();
+
+    printf("%-10s %16s %12s %12s %16s %16s\n", "producers", "loop tasks/s", "wakeups", "suppressed", "mpsc push/s",
+           "mutex push/s");
+    for (int producers : producer_counts) {
+        uint64_t wakeups = loop->wakeups();
+        uint64_t suppressed = loop->suppressed_wakeups();
+        double loop_rate = RunLoopCase(loop, producers, per_producer);
+        wakeups = loop->wakeups() - wakeups;
+        suppressed = loop->suppressed_wakeups() - suppressed;
+        double mpsc_rate = RunQueueCase<MpscQueue<int>>(producers, per_producer);
+        double mutex_rate = RunQueueCase<MutexQueue>(producers, per_producer);
+        printf("%-10d %16.0f %12lu %12lu %16.0f %16.0f\n", producers, loop_rate, wakeups, suppressed, mpsc_rate,
+               mutex_rate);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+// 上游连接池基准: 同样保持 window 个在途请求(按行协议, 后端回显),
+// 1. pool: UpstreamPool 的常驻连接上 pipelining
+// 2. connect-per-request: 每个请求新建一个 TcpClient 连接, 收到响应后由后端关闭
+// 用法: upstream_pool_bench [在途请求数=64] [连接池连接数=4] [秒数=2]
+
+#include <signal.h>
+#include <stdlib.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+//
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/tcp_client.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+#include <cutemuduo/tcp_server.hpp>
+#include <cutemuduo/upstream_pool.hpp>
+//
+#include "bench_util.hpp"
+
+using namespace cutemuduo;
+
+struct RunResult {
+    uint64_t completed = 0;
+    uint64_t failed = 0;
+    double seconds = 0;
+    std::vector<int64_t> latencies;  // 纳秒
+};
+
+static char const kRequest[] = "GET /upstream\n";
+
+// 按行切分响应
+static ssize_t LineFramer(Buffer const* buf) {
+    auto begin = buf->Peek();
+    auto end = static_cast<char const*>(memchr(begin, '\n', buf->ReadableBytes()));
+    return end ? end + 1 - begin : 0;
+}
+
+static RunResult RunPool(uint16_t port, int window, size_t connections, std::chrono::milliseconds duration) {
+    EventLoop loop;
+    UpstreamPool::Options options;
+    options.connections = connections;
+    options.max_pending_per_connection = static_cast<size_t>(window);
+    UpstreamPool pool(&loop, InetAddress(port, "127.0.0.1"), "bench", LineFramer, options);
+    pool.Start();
+
+    RunResult result;
+    int64_t end = 0;
+    std::function<void()> issue = [&] {
+        int64_t sent_at = bench::NowNs();
+        pool.Request(kRequest, [&, sent_at](bool ok, std::string_view) {
+            int64_t now = bench::NowNs();
+            if (ok) {
+                ++result.completed;
+                result.latencies.push_back(now - sent_at);
+            } else {
+                ++result.failed;
+            }
+            if (now < end) {
+                issue();
+            } else if (pool.pending() == 0) {
+                loop.Quit();
+            }
+        });
+    };
+    // NOTE: 等连接全部建立后再开始计时
+    std::function<void()> wait_connected = [&] {
+        if (pool.connected() < connections) {
+            loop.RunAfter(std::chrono::milliseconds(10), [&] { wait_connected(); });
+            return;
+        }
+        end = bench::NowNs() + std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        for (int i = 0; i < window; ++i) {
+            issue();
+        }
+    };
+    loop.QueueInLoop([&] { wait_connected(); });
+    int64_t start = bench::NowNs();
+    loop.Loop();
+    result.seconds = static_cast<double>(bench::NowNs() - start) / 1e9;
+    return result;
+}
+
+static RunResult RunConnectPerRequest(uint16_t port, int window, std::chrono::milliseconds duration) {
+    EventLoop loop;
+    RunResult result;
+    int64_t end = bench::NowNs() + std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    int active = 0;
+    std::function<void()> issue = [&] {
+        ++active;
+        int64_t sent_at = bench::NowNs();
+        auto client = std::make_shared<std::unique_ptr<TcpClient>>(
+            std::make_unique<TcpClient>(&loop, InetAddress(port, "127.0.0.1"), "bench"));
+        auto replied = std::make_shared<bool>(false);
+        (*client)->SetConnectionCallback([&, client, replied, sent_at](TcpConnectionPtr const& conn) {
+            if (conn->IsConnected()) {
+                conn->SetTcpNoDelay(true);
+                conn->Send(std::string(kRequest));
+                return;
+            }
+            // 连接关闭: 本次请求结束, TcpClient 在任务阶段销毁(不能在自己的回调中析构)
+            int64_t now = bench::NowNs();
+            if (*replied) {
+                ++result.completed;
+                result.latencies.push_back(now - sent_at);
+            } else {
+                ++result.failed;
+            }
+            loop.QueueInLoop([client] { client->reset(); });
+            --active;
+            if (now < end) {
+                issue();
+            } else if (active == 0) {
+                loop.Quit();
+            }
+        });
+        (*client)->SetMessageCallback([replied](TcpConnectionPtr const&, Buffer* buf, Timestamp) {
+            if (LineFramer(buf) > 0) {
+                *replied = true;
+                buf->RetrieveAll();
+            }
+        });
+        (*client)->Connect();
+    };
+    for (int i = 0; i < window; ++i) {
+        issue();
+    }
+    int64_t start = bench::NowNs();
+    loop.Loop();
+    result.seconds = static_cast<double>(bench::NowNs() - start) / 1e9;
+    return result;
+}
+
+static void Print(char const* name, RunResult& r) {
+    printf("%-20s %12.0f %10lu %10.1f %10.1f\n", name, static_cast<double>(r.completed) / r.seconds, r.failed,
+           bench::Percentile(r.latencies, 50) / 1e3, bench::Percentile(r.latencies, 99) / 1e3);
+}
+
+int main(int argc, char* argv[]) {
+    int window = argc > 1 ? atoi(argv[1]) : 64;
+    size_t connections = static_cast<size_t>(argc > 2 ? atoi(argv[2]) : 4);
+    auto duration = std::chrono::milliseconds(static_cast<int>((argc > 3 ? atof(argv[3]) : 2.0) * 1000));
+
+    bench::SilenceLogger();
+    bench::RaiseFdLimit();
+    signal(SIGPIPE, SIG_IGN);
+
+    // 后端: 按行回显; 短连接端口回显后关闭连接(由后端主动关闭, TIME_WAIT 不占用客户端的临时端口)
+    uint16_t port = 19400;
+    uint16_t short_port = 19401;
+    EventLoop backend_loop;
+    TcpServer backend(&backend_loop, InetAddress(port), "Backend");
+    TcpServer short_backend(&backend_loop, InetAddress(short_port), "ShortBackend");
+    for (auto server : {&backend, &short_backend}) {
+        server->SetThreadNum(2);
+        server->SetConnectionCallback([](TcpConnectionPtr const& conn) {
+            if (conn->IsConnected()) {
+                conn->SetTcpNoDelay(true);
+            }
+        });
+    }
+    backend.SetMessageCallback([](TcpConnectionPtr const& conn, Buffer* buf, Timestamp) { conn->Send(buf); });
+    short_backend.SetMessageCallback([](TcpConnectionPtr const& conn, Buffer* buf, Timestamp) {
+        conn->Send(buf);
+        conn->Shutdown();
+    });
+    backend.Start();
+    short_backend.Start();
+    std::thread backend_thread([&] { backend_loop.Loop(); });
+
+    printf("in flight: %d, pool connections: %zu\n", window, connections);
+    printf("%-20s %12s %10s %10s %10s\n", "case", "requests/s", "failed", "p50(us)", "p99(us)");
+    // NOTE: one loop per thread, 客户端的 EventLoop 在单独的线程中运行
+    RunResult pooled;
+    std::thread([&] { pooled = RunPool(port, window, connections, duration); }).join();
+    Print("pool", pooled);
+    fflush(stdout);
+    RunResult per_request;
+    std::thread([&] { per_request = RunConnectPerRequest(short_port, window, duration); }).join();
+    Print("connect-per-request", per_request);
+
+    backend_loop.Quit();
+    backend_thread.join();
+    return 0;
+}
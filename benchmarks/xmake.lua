@@ -0,0 +1,59 @@
+target("poller_bench", function()
+    set_kind("binary")
+    add_files("poller_bench.cpp")
+    add_deps("cutemuduo")
+end)
+
+target("queue_in_loop_bench", function()
+    set_kind("binary")
+    add_files("queue_in_loop_bench.cpp")
+    add_deps("cutemuduo")
+end)
+
+target("affinity_bench", function()
+    set_kind("binary")
+    add_files("affinity_bench.cpp")
+    add_deps("cutemuduo")
+end)
+
+target("conn_storm_bench", function()
+    set_kind("binary")
+    add_files("conn_storm_bench.cpp")
+    add_deps("cutemuduo")
+end)
+
+target("channel_dispatch_bench", function()
+    set_kind("binary")
+    add_files("channel_dispatch_bench.cpp")
+    add_deps("cutemuduo")
+end)
+
+target("upstream_pool_bench", function()
+    set_kind("binary")
+    add_files("upstream_pool_bench.cpp")
+    add_deps("cutemuduo")
+end)
+
+target("load_generator", function()
+    set_kind("binary")
+    add_files("load_generator.cpp")
+    add_deps("cutemuduo")
+end)
+
+target("micro_bench", function()
+    set_kind("binary")
+    add_files("micro_bench.cpp")
+    add_deps("cutemuduo")
+end)
+
+target("pingpong_server", function()
+    set_kind("binary")
+    add_files("pingpong_server.cpp")
+    add_deps("cutemuduo")
+end)
+
+target("pingpong_client", function()
+    set_kind("binary")
+    add_files("pingpong_client.cpp")
+    add_deps("cutemuduo")
+end)
@@ -0,0 +1,49 @@
+// 协程版按行回显服务器: 每个连接一个协程, 顺序地读一行、写一行
+// 输入 "sleep" 时先等待 1 秒再回显, 演示 co_await loop->Sleep
+
+#include <chrono>
+#include <string>
+//
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/coroutine.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/logger.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+#include <cutemuduo/tcp_server.hpp>
+
+using namespace cutemuduo;
+
+// 一个连接的完整处理流程, 不需要状态机和 SetContext
+static Task<void> HandleConnection(TcpConnectionPtr conn) {
+    co_await conn->Write("welcome to CuteMuduo coroutine echo server\r\n");
+    while (true) {
+        std::string line = co_await conn->ReadUntil("\n");
+        if (line.empty() || line.back() != '\n') {
+            break;  // 对端关闭
+        }
+        if (line.rfind("sleep", 0) == 0) {
+            co_await conn->GetLoop()->Sleep(std::chrono::seconds(1));
+        }
+        if (!co_await conn->Write(line)) {
+            break;
+        }
+    }
+    LOG_INFO("CoEchoServer - %s handler done\n", conn->GetName().c_str());
+}
+
+int main() {
+    EventLoop loop;
+    InetAddress addr{9013};
+    TcpServer server{&loop, addr, "CoEchoServer"};
+    server.SetConnectionCallback([](TcpConnectionPtr const& conn) {
+        if (conn->IsConnected()) {
+            Spawn(HandleConnection(conn));
+        }
+    });
+    server.SetMessageCallback([](TcpConnectionPtr const&, Buffer*, Timestamp) {});
+    server.SetThreadNum(4);
+    server.Start();
+    loop.Loop();
+    return 0;
+}
@@ -43,7 +43,7 @@ private:
     // 用户自定义收到消息后回调函数
     void UserDefineMessageCallback(TcpConnectionPtr const& conn_ptr, Buffer* buf) {
         auto msg{buf->RetrieveAllAsString()};  // 读出 buffer 中收到的所有数据
-        conn_ptr->Send(msg);                   // echo 回声, 返回给客户端
+        conn_ptr->Send(std::move(msg));        // echo 回声, 返回给客户端
         // conn_ptr->Shutdown();                  // 关闭连接
     }
 
@@ -0,0 +1,226 @@
+// TcpServer::Stop 测试: 空闲连接、还没发过请求的新连接、还有响应没发完的连接,
+// 以及(隔一轮一次)对端一直不接收、超时后被强制关闭的连接
+// 用法: graceful_stop_test [轮数=20] [端口=9017]
+//
+// 每一轮:
+// - 空闲连接: 先完成一次小请求的往返, 之后不再发送也不关闭, Stop 后立即被关闭, 客户端读到 EOF
+// - 新连接: 建立后不发送, 等空闲连接都读到 EOF(Stop 已经开始)后才发出第一个请求, 要收到回显后再读到 EOF
+// - 忙连接: 先完成一次小请求的往返, 再发出一个大请求, 服务端全部收到后才 Stop, 此时回显大多还在输出缓冲区中;
+//   客户端要完整收到回显后再读到 EOF(优雅关闭先发送完输出缓冲区)
+// - 卡住的连接(奇数轮): 发出一个很大的请求后在 Stop 完成前不再接收, 超时后被强制关闭, 客户端最终读到 EOF
+// - Stop 的结果: 没有卡住的连接时 drained=true, 否则 drained=false; 完成回调执行时服务端的每个连接都已经销毁
+//   (ConnectDestroyed 执行完, 没有留在已经退出的 Subloop 的任务队列中), 服务器的连接数回到 0
+// 所有轮次都满足时测试通过
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+//
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+#include <cutemuduo/tcp_server.hpp>
+
+using namespace cutemuduo;
+
+static constexpr int kBusyConnections = 4;
+static constexpr int kIdleConnections = 32;
+static constexpr int kFreshConnections = 4;
+static constexpr int kClientRcvBuf = 64 << 10;          // 客户端接收缓冲区调小, 回显更容易积压在服务端
+static constexpr size_t kBusyRequestBytes = 8 << 20;    // 大于服务端 socket 发送缓冲区的上限, 回显一定积压在输出缓冲区
+static constexpr size_t kStuckRequestBytes = 32 << 20;  // 对端不接收时一定发不完
+static constexpr auto kStopTimeout = std::chrono::milliseconds(300);
+
+static int Connect(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &kClientRcvBuf, sizeof(kClientRcvBuf));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool WriteAll(int fd, std::string const& data) {
+    size_t written = 0;
+    ssize_t n;
+    while (written < data.size() && (n = write(fd, data.data() + written, data.size() - written)) > 0) {
+        written += static_cast<size_t>(n);
+    }
+    return written == data.size();
+}
+
+// 读取与 request 同样长度的回显
+static bool ReadReply(int fd, std::string const& request) {
+    std::string reply(request.size(), '\0');
+    size_t received = 0;
+    ssize_t n;
+    while (received < reply.size() && (n = read(fd, reply.data() + received, reply.size() - received)) > 0) {
+        received += static_cast<size_t>(n);
+    }
+    return reply == request;
+}
+
+// 发送 request 并读取回显
+static bool RoundTrip(int fd, std::string const& request) {
+    return WriteAll(fd, request) && ReadReply(fd, request);
+}
+
+// 读到 EOF(或连接被重置)返回 true
+static bool WaitEof(int fd) {
+    char buf[64];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    }
+    return n == 0 || errno == ECONNRESET;
+}
+
+struct RoundResult {
+    bool drained = true;
+    int replies = 0;      // 完整收到的回显
+    int eofs = 0;         // 读到 EOF 的连接
+    int alive = 0;        // 完成回调时还没有销毁的服务端连接
+    size_t leftover = 0;  // 完成回调时服务器的连接数
+};
+
+static RoundResult RunRound(uint16_t port, bool with_stuck) {
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port), "GracefulStopTest");
+    server.SetThreadNum(2);
+    std::mutex mtx;
+    std::vector<std::weak_ptr<TcpConnection>> conns;  // 服务端的所有连接
+    server.SetConnectionCallback([&](TcpConnectionPtr const& conn_ptr) {
+        if (conn_ptr->IsConnected()) {
+            std::lock_guard lk(mtx);
+            conns.push_back(conn_ptr);
+        }
+    });
+    std::atomic<size_t> received{0};  // 服务端收到的字节数
+    server.SetMessageCallback([&](TcpConnectionPtr const& conn_ptr, Buffer* buf, Timestamp) {
+        received.fetch_add(buf->ReadableBytes());
+        conn_ptr->Send(buf);
+    });
+    server.Start();
+
+    RoundResult result;
+    std::atomic<bool> stopped{false};
+    std::thread clients([&] {
+        std::vector<int> busy;
+        std::vector<int> idle;
+        std::vector<int> fresh;
+        int stuck = -1;
+        for (int i = 0; i < kBusyConnections; ++i) {
+            busy.push_back(Connect(port));
+        }
+        for (int i = 0; i < kIdleConnections; ++i) {
+            idle.push_back(Connect(port));
+        }
+        for (int i = 0; i < kFreshConnections; ++i) {
+            fresh.push_back(Connect(port));
+        }
+        if (with_stuck) {
+            stuck = Connect(port);
+        }
+        int expected_conns = kBusyConnections + kIdleConnections + kFreshConnections + (with_stuck ? 1 : 0);
+        while (server.connections() < static_cast<size_t>(expected_conns)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::string const small = "before stop";
+        for (int fd : busy) {
+            result.replies += RoundTrip(fd, small);
+        }
+        for (int fd : idle) {
+            result.replies += RoundTrip(fd, small);
+        }
+        // 大请求: 发出后先不接收回显, 服务端全部收到之后再 Stop
+        std::string const big(kBusyRequestBytes, 'b');
+        size_t expected_bytes = small.size() * (kBusyConnections + kIdleConnections) + big.size() * kBusyConnections;
+        for (int fd : busy) {
+            WriteAll(fd, big);
+        }
+        if (with_stuck) {
+            WriteAll(stuck, std::string(kStuckRequestBytes, 's'));
+            expected_bytes += kStuckRequestBytes;
+        }
+        while (received.load() < expected_bytes) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        // NOTE: Stop 在 Mainloop 中执行, 完成回调中检查服务端连接并退出 Mainloop
+        server.Stop(kStopTimeout, [&](bool drained) {
+            result.drained = drained;
+            std::lock_guard lk(mtx);
+            for (auto& conn : conns) {
+                result.alive += !conn.expired();
+            }
+            result.leftover = server.connections();  // NOTE: 此时 Subloop 已经退出, 不能再访问它们
+            stopped = true;
+            loop.Quit();
+        });
+        for (int fd : busy) {
+            result.replies += ReadReply(fd, big);  // 优雅关闭先发送完输出缓冲区
+            result.eofs += WaitEof(fd);
+            close(fd);
+        }
+        for (int fd : idle) {
+            result.eofs += WaitEof(fd);
+            close(fd);
+        }
+        std::string const late = "after stop";
+        for (int fd : fresh) {
+            result.replies += RoundTrip(fd, late);  // 第一个请求在 Stop 之后才到达, 照常处理
+            result.eofs += WaitEof(fd);
+            close(fd);
+        }
+        if (with_stuck) {
+            while (!stopped) {  // Stop 完成之前一直不接收
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            result.eofs += WaitEof(stuck);
+            close(stuck);
+        }
+    });
+    loop.Loop();
+    clients.join();
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    uint16_t port = static_cast<uint16_t>(argc > 2 ? atoi(argv[2]) : 9017);
+    signal(SIGPIPE, SIG_IGN);
+    std::cout.setstate(std::ios::failbit);  // 关闭 cutemuduo 的日志输出(Logger 写 std::cout)
+
+    int failed = 0;
+    for (int i = 0; i < rounds; ++i) {
+        bool with_stuck = i % 2 == 1;
+        RoundResult r = RunRound(port, with_stuck);
+        int expected_eofs = kBusyConnections + kIdleConnections + kFreshConnections + (with_stuck ? 1 : 0);
+        int expected_replies = 2 * kBusyConnections + kIdleConnections + kFreshConnections;
+        bool ok = r.drained == !with_stuck && r.replies == expected_replies && r.eofs == expected_eofs &&
+                  r.alive == 0 && r.leftover == 0;
+        if (!ok) {
+            ++failed;
+            printf("round %d: stuck=%d drained=%d replies=%d/%d eofs=%d/%d alive=%d leftover=%zu\n", i + 1,
+                   with_stuck, r.drained, r.replies, expected_replies, r.eofs, expected_eofs, r.alive, r.leftover);
+        }
+    }
+    printf("rounds: %d, failed: %d\n%s\n", rounds, failed, failed == 0 ? "PASSED" : "FAILED");
+    return failed == 0 ? 0 : 1;
+}
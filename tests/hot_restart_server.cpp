@@ -0,0 +1,43 @@
+// 可热重启的 echo 服务器: 再启动一个同样的进程即完成重启
+// 新进程从旧进程接过监听 socket 开始 accept, 旧进程不再 accept, 处理完已有连接后退出(见 hot_restart.hpp)
+// 用法: hot_restart_server [端口=9014]
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+//
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/hot_restart.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/logger.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+#include <cutemuduo/tcp_server.hpp>
+
+using namespace cutemuduo;
+
+int main(int argc, char* argv[]) {
+    uint16_t port = static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 9014);
+
+    EventLoop loop;
+    // NOTE: 控制地址用抽象命名空间, 进程退出后不会残留 socket 文件
+    HotRestart restart(&loop, InetAddress::UnixAbstract("cutemuduo-hot-restart-" + std::to_string(port)));
+    TcpServer server(&loop, InetAddress(port), "HotRestartServer");
+    server.AdoptListenSockets(restart.Takeover());  // 没有旧进程时为空, 自己 bind
+    server.SetThreadNum(2);
+    server.SetConnectionCallback([](TcpConnectionPtr const&) {});
+    server.SetMessageCallback(
+        [](TcpConnectionPtr const& conn_ptr, Buffer* buf, Timestamp) { conn_ptr->Send(buf->RetrieveAllAsString()); });
+    server.Start();
+
+    // 监听 socket 交给新进程之后: 优雅停止, 已有连接处理完(或超时)后退出
+    restart.Serve(&server, [&] {
+        LOG_INFO("pid %d handed off, draining\n", getpid());
+        server.Stop(std::chrono::seconds(5), [&](bool drained) {
+            LOG_INFO("pid %d stopped, drained=%d\n", getpid(), drained);
+            loop.Quit();
+        });
+    });
+    loop.Loop();
+    return 0;
+}
@@ -0,0 +1,151 @@
+// 热重启测试: 在持续的连接负载下反复重启 hot_restart_server, 统计失败的连接
+// 用法: hot_restart_test [重启次数=10] [客户端线程数=4] [端口=9015]
+// NOTE: hot_restart_server 需与本程序在同一个目录中
+//
+// 每个客户端线程不停地 建立连接 -> 发送 -> 收到回显 -> 关闭; 每隔 300ms 启动一个新的服务器进程(自动接管),
+// 上一个进程应当在处理完已有连接后自行退出
+// 连接失败数和请求失败数都为 0 且所有旧进程都已退出时测试通过: 旧进程刚 accept、请求还没读到的连接
+// 在优雅停止期间照常得到响应(见 TcpConnection::DrainAndClose)
+
+#include <arpa/inet.h>
+#include <linux/limits.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct LoadStats {
+    std::atomic<uint64_t> requests{0};         // 完成的请求(收到完整回显)
+    std::atomic<uint64_t> connect_failures{0};  // connect 失败(被拒绝/重置)
+    std::atomic<uint64_t> request_failures{0};  // 连接建立之后没有收到完整回显
+};
+
+static std::string ServerPath() {
+    char path[PATH_MAX];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    std::string self(path, n > 0 ? static_cast<size_t>(n) : 0);
+    return self.substr(0, self.rfind('/') + 1) + "hot_restart_server";
+}
+
+static pid_t SpawnServer(std::string const& path, uint16_t port) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        std::string port_arg = std::to_string(port);
+        execl(path.c_str(), path.c_str(), port_arg.c_str(), nullptr);
+        perror("execl");
+        _exit(127);
+    }
+    return pid;
+}
+
+static int Connect(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void RunClient(uint16_t port, std::atomic<bool>* stop, LoadStats* stats) {
+    char const request[] = "hot restart";
+    while (!stop->load(std::memory_order_relaxed)) {
+        int fd = Connect(port);
+        if (fd < 0) {
+            stats->connect_failures.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        size_t received = 0;
+        char buf[sizeof(request)];
+        if (write(fd, request, sizeof(request)) == sizeof(request)) {
+            ssize_t n;
+            while (received < sizeof(request) && (n = read(fd, buf + received, sizeof(buf) - received)) > 0) {
+                received += static_cast<size_t>(n);
+            }
+        }
+        (received == sizeof(request) ? stats->requests : stats->request_failures).fetch_add(1);
+        close(fd);
+    }
+}
+
+// 等待进程退出, 超时返回 false
+static bool WaitExit(pid_t pid, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        int status = 0;
+        if (waitpid(pid, &status, WNOHANG) == pid) {
+            return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    int restarts = argc > 1 ? atoi(argv[1]) : 10;
+    int clients = argc > 2 ? atoi(argv[2]) : 4;
+    uint16_t port = static_cast<uint16_t>(argc > 3 ? atoi(argv[3]) : 9015);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::string path = ServerPath();
+    pid_t server = SpawnServer(path, port);
+    int probe = -1;
+    for (int i = 0; i < 500 && probe < 0; ++i) {  // 等待第一个进程开始监听
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        probe = Connect(port);
+    }
+    if (probe < 0) {
+        fprintf(stderr, "%s did not start listening on port %u\n", path.c_str(), port);
+        kill(server, SIGKILL);
+        return 1;
+    }
+    close(probe);
+
+    LoadStats stats;
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; ++i) {
+        threads.emplace_back(RunClient, port, &stop, &stats);
+    }
+
+    int unclean_exits = 0;
+    for (int i = 0; i < restarts; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        pid_t next = SpawnServer(path, port);
+        if (!WaitExit(server, std::chrono::seconds(10))) {
+            fprintf(stderr, "restart %d: previous server %d did not exit cleanly\n", i + 1, server);
+            kill(server, SIGKILL);
+            waitpid(server, nullptr, 0);
+            ++unclean_exits;
+        }
+        server = next;
+        printf("restart %d: requests=%lu connect_failures=%lu request_failures=%lu\n", i + 1,
+               stats.requests.load(), stats.connect_failures.load(), stats.request_failures.load());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    kill(server, SIGTERM);
+    waitpid(server, nullptr, 0);
+
+    printf("restarts: %d, requests: %lu, connect failures: %lu, request failures: %lu, unclean exits: %d\n", restarts,
+           stats.requests.load(), stats.connect_failures.load(), stats.request_failures.load(), unclean_exits);
+    bool passed = stats.connect_failures == 0 && stats.request_failures == 0 && unclean_exits == 0;
+    printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
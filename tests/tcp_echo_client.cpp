@@ -0,0 +1,47 @@
+// 非阻塞 echo 客户端(TcpClient): 连接 echo_server(端口 9012), 每秒发送一行并打印回显
+// 服务器没有启动或中途退出时按指数退避自动重连
+// 用法: tcp_echo_client [ip=127.0.0.1] [端口=9012]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <string>
+//
+#include <cutemuduo/buffer.hpp>
+#include <cutemuduo/event_loop.hpp>
+#include <cutemuduo/inet_address.hpp>
+#include <cutemuduo/logger.hpp>
+#include <cutemuduo/tcp_client.hpp>
+#include <cutemuduo/tcp_connection.hpp>
+
+using namespace cutemuduo;
+
+int main(int argc, char* argv[]) {
+    std::string ip = argc > 1 ? argv[1] : "127.0.0.1";
+    uint16_t port = static_cast<uint16_t>(argc > 2 ? atoi(argv[2]) : 9012);
+
+    EventLoop loop;
+    TcpClient client(&loop, InetAddress(port, ip), "TcpEchoClient");
+    client.SetConnectionCallback([](TcpConnectionPtr const& conn_ptr) {
+        LOG_INFO("TcpEchoClient - %s -> %s is %s", conn_ptr->GetLocalAddress().ToIpPort().c_str(),
+                 conn_ptr->GetPeerAddress().ToIpPort().c_str(), conn_ptr->IsConnected() ? "UP" : "DOWN");
+    });
+    client.SetMessageCallback([](TcpConnectionPtr const&, Buffer* buf, Timestamp) {
+        printf("echo: %s", buf->RetrieveAllAsString().c_str());
+        fflush(stdout);
+    });
+    client.SetAutoReconnect(true);
+    client.SetRetryDelay(std::chrono::milliseconds(200), std::chrono::seconds(5));
+    client.Connect();
+
+    int seq = 0;
+    loop.RunEvery(std::chrono::seconds(1), [&] {
+        // NOTE: 定时器和连接在同一个 loop 线程中, 断线期间 connection() 为空, 这一秒的消息不发送
+        if (auto conn_ptr = client.connection()) {
+            conn_ptr->Send("hello #" + std::to_string(++seq) + "\n");
+        }
+    });
+    loop.Loop();
+    return 0;
+}
@@ -4,11 +4,41 @@ target("echo_server", function()
     add_deps("cutemuduo")
 end)
 
+target("co_echo_server", function()
+    set_kind("binary")
+    add_files("co_echo_server.cpp")
+    add_deps("cutemuduo")
+end)
+
+target("hot_restart_server", function()
+    set_kind("binary")
+    add_files("hot_restart_server.cpp")
+    add_deps("cutemuduo")
+end)
+
+target("hot_restart_test", function()
+    set_kind("binary")
+    add_files("hot_restart_test.cpp")
+    add_deps("hot_restart_server")
+end)
+
+target("graceful_stop_test", function()
+    set_kind("binary")
+    add_files("graceful_stop_test.cpp")
+    add_deps("cutemuduo")
+end)
+
 target("echo_client", function()
     set_kind("binary")
     add_files("echo_client.cpp")
 end)
 
+target("tcp_echo_client", function()
+    set_kind("binary")
+    add_files("tcp_echo_client.cpp")
+    add_deps("cutemuduo")
+end)
+
 -- add_deps("cutemuduo")
 
 -- for _, sourcefile in ipairs(os.files("*.cpp")) do
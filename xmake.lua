@@ -14,3 +14,4 @@ set_defaultmode("debug")
 
 includes("CuteMuduo")
 includes("tests")
+includes("benchmarks")